@@ -5,24 +5,112 @@
 #include <fstream>
 #include <cmath>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <Eigen/Dense>
 
 #include <mrpt/math/ransac_applications.h>
 #include <mrpt/system/CTicTac.h>
 
+#include "lane_shm.h"
+
 
 
 namespace RansacNamespace {
 
-    typedef std::vector<std::vector<double>> vec;
-    typedef  mrpt::math::CVectorDouble CVD ;
-    typedef std::vector<mrpt::math::TLine2D> TL;
+    /// Максимальное количество полос (линий разметки) в кадре.
+    constexpr size_t max_stripes = 8;
+
+    /**
+     * Линия разметки на изображении сверху: col = a*row^2 + b*row + c.
+     * Прямые RANSAC хранятся в том же виде с a = 0. Нулевая линия - линия не найдена.
+     */
+    struct LanePoly {
+        float a;
+        float b;
+        float c;
+
+        /// Столбец линии в строке row (расчёт в double).
+        double x(double row) const {
+            return (static_cast<double>(a) * row + static_cast<double>(b)) * row + static_cast<double>(c);
+        }
+        /// Линия найдена (коэффициент c не нулевой).
+        bool found() const {
+            return (c < -0.0001f) || (c > 0.0001f);
+        }
+    };
+
+    /// Линии по полосам. POD фиксированного размера, копируется без выделения памяти.
+    struct lane_polys {
+        /// Количество полос
+        uint32_t count;
+        LanePoly stripe[max_stripes];
+        /// Доля строк с разметкой вдоль линии (см. mask_profile())
+        float duty[max_stripes];
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        /// Задаёт количество полос (не больше max_stripes) и обнуляет все линии.
+        void reset(size_t n) {
+            count = static_cast<uint32_t>(std::min(n, max_stripes));
+            for (auto &line : stripe)
+                line = LanePoly{0, 0, 0};
+            for (auto &d : duty)
+                d = 0;
+        }
+        LanePoly& operator[](size_t i) { return stripe[i]; }
+        const LanePoly& operator[](size_t i) const { return stripe[i]; }
+        LanePoly* begin() { return stripe; }
+        LanePoly* end() { return stripe + count; }
+        const LanePoly* begin() const { return stripe; }
+        const LanePoly* end() const { return stripe + count; }
+    };
+
+    /**
+     * Точки разметки в виде структуры массивов: строки и столбцы отдельно, float.
+     * Массивы передаются в RANSAC MRPT напрямую, без копирования и перестановки координат.
+     */
+    struct point_buffer {
+        mrpt::math::CVectorFloat rows;
+        mrpt::math::CVectorFloat cols;
+
+        size_t size() const { return rows.size(); }
+        bool empty() const { return rows.size() == 0; }
+        /// Размер уменьшается без освобождения памяти.
+        void clear() {
+            rows.resize(0);
+            cols.resize(0);
+        }
+        /// Добавляет точки контура (x - столбец, y - строка).
+        void append(const std::vector<cv::Point>& points) {
+            size_t n = size();
+            rows.resize(n + points.size());
+            cols.resize(n + points.size());
+            for (size_t i = 0; i < points.size(); i++) {
+                rows[n + i] = static_cast<float>(points[i].y);
+                cols[n + i] = static_cast<float>(points[i].x);
+            }
+        }
+    };
+
+    /// Счётчики по полосам (фиксированный размер, без выделения памяти).
+    using stripe_counters = std::array<int, max_stripes>;
+    /// Флаги по полосам.
+    using stripe_flags = std::array<bool, max_stripes>;
 
     /// settings.cpp
     class settings{
     public:
         /// Путь до видео фрагмента
         std::string video_name;
+        /// Формат кадров: "bgr", "nv12" или "i420" (YUV обрабатывается без перевода в BGR)
+        std::string input_format;
         ///  Значение чувствительности к белым пикселям. Чем больше значение, тем больше вероятность обнаружить прерывистую линию.
         int sens_for_type;
         ///  Параметры шрифта
@@ -31,6 +119,8 @@ namespace RansacNamespace {
         int thickness;
         ///  Ширина детектируемой линии
         int width_line_search;
+        /// Минимальная доля строк с разметкой вдоль линии, при которой линия считается сплошной
+        double solid_duty;
         ///   Пороговое значение для определения, является ли точка внутри линии.
         double Dist_threshold;
         ///  Значение для сглаживания данных, чем больше значение, тем больше потенциальных выбросов
@@ -51,84 +141,1298 @@ namespace RansacNamespace {
         double w1920_to_width;
         double h1080_to_height;
 
+        /// Формат телеметрии: "jsonl", "csv" или "bin"
+        std::string telemetry_format;
+        /// Файл для записи телеметрии (пустая строка - stdout)
+        std::string telemetry_path;
+        /// Максимальная частота записей телеметрии, Гц (0 - без ограничения)
+        double telemetry_rate_hz;
+        /// Размер очереди телеметрии (количество кадров)
+        size_t telemetry_queue_size;
+
+        /// Имя сегмента разделяемой памяти для публикации результатов (пустая строка - не публиковать)
+        std::string shm_name;
+        /// Количество слотов в кольце разделяемой памяти
+        uint32_t shm_capacity;
+
+        /// Масштаб изображения сверху для грубого поиска линий (1 - без пирамиды, поиск в полном разрешении)
+        double pyramid_scale;
+        /// Половина ширины полосы уточнения вокруг найденной линии, пиксели изображения сверху
+        int pyramid_margin;
+        /// Половина ширины полосы вокруг линий предыдущего кадра, в которой ищутся линии (0 - поиск по всему изображению)
+        int roi_margin;
+        /// Период (кадры), с которым кадр обрабатывается целиком для поиска новых линий
+        int roi_reacquire_interval;
+        /// 1 - разреженный front end: фильтр в кадре камеры внутри трапеции, в изображение сверху переводятся только пятна разметки
+        int sparse_front;
+        /// Порог изменения сцены: максимальная разница средней яркости клетки сигнатуры трапеции (0 - каждый кадр обрабатывается)
+        double static_threshold;
+        /// Максимальное количество кадров подряд, для которых повторяется результат неизменной сцены
+        int static_max_reuse;
+        /// Шаг строк выделения точек для RANSAC по строкам маски (0 - точки контуров, см. scan_line_points())
+        int scan_step;
+        /// Максимальное количество точек для RANSAC на кадр при выделении по строкам
+        size_t scan_budget;
+        /// Целевое время обработки кадра, мс: регулятор качества снижает качество, пока кадр не укладывается (0 - выключено)
+        double target_frame_ms;
+        /// Количество кадров между решениями регулятора
+        int quality_window;
+        /// Нижние границы регулятора: масштаб грубого поиска, бюджет точек RANSAC и ширина полосы слежения
+        double quality_min_scale;
+        size_t quality_min_budget;
+        int quality_roi_margin;
+        /// Шаг строк, с которым регулятор включает точки по строкам, если scan_step = 0
+        int quality_scan_step;
+        /// Порт HTTP метрик в формате Prometheus на 127.0.0.1 (0 - выключено)
+        int metrics_port;
+
         ///Параметры калибровки
         Eigen::Matrix3d transformationMatrix;
         settings();
         std::vector<cv::Point2d> get_vector_stripes_width(double width);
+
+        /// Загружает параметры из файла конфигурации (YAML/XML cv::FileStorage). Отсутствующие ключи не меняются.
+        bool load(const std::string& path);
+        /// Сохраняет все параметры в файл конфигурации.
+        bool save(const std::string& path) const;
+        /// Проверяет допустимость значений параметров.
+        bool validate() const;
     };
 
     ///Bird_view.cpp
     class Bird_view {
     public:
-        static cv::Mat warpImage (const cv::Mat& img, const cv::Mat& img_norm, std::vector<cv::Mat>& matrix,std::vector<int> &parameters, char type_of_transform = 'n');
-        void get_parameters(const std::string& vide_name);
+        static void warpImage (const cv::Mat& img, const cv::Mat& img_norm, std::vector<cv::Mat>& matrix, std::vector<int> &parameters,
+                               cv::Mat& warped_img, char type_of_transform = 'n');
+        /// tuning.cpp (интерактивная настройка, только в lane_tune)
+        void get_parameters(cv::VideoCapture& vid, std::vector<int>& parameters);
         static std::vector<cv::Mat> return_bird_matrix(std::vector<int> &parameters);
     };
 
 
     ///HSV.cpp
+    /// Формат кадра на входе детектора
+    enum class frame_format {
+        /// Цветное изображение BGR (cv::VideoCapture по умолчанию)
+        bgr,
+        /// YUV 4:2:0: плоскость Y, затем чередующиеся U, V (одноканальное изображение высотой 3/2 кадра)
+        nv12,
+        /// YUV 4:2:0: плоскости Y, U, V подряд
+        i420
+    };
+    bool parse_frame_format(const std::string& name, frame_format& format);
+
     class hsv {
     public:
-        static cv::Mat return_hsv(const cv::Mat& img, std::vector<int> &parameters);
-        static void get_parameters(const std::string& vide_name);
-        static  void filtered_img(const cv::Mat& img,  std::vector<std::vector<cv::Point>>& filtered_contours, std::vector<cv::Point>& filtered_coord);
+        /// Промежуточные данные filtered_img, переиспользуемые между кадрами
+        struct filter_buffers {
+            cv::Mat kernel;
+            /// Масштаб, для которого построено ядро (0 - ядра нет)
+            double kernel_scale = 0;
+            cv::Mat eroded;
+            std::vector<std::vector<cv::Point>> contours;
+            std::vector<cv::Vec4i> hierarchy;
+        };
+
+        /**
+         * Пороги parametersHSV, переведённые в YUV: 1 байт на сочетание Y и U, V, квантованных по 8 (256 КБ).
+         * Погрешность квантования цветности - не больше 4 уровней на границе диапазона.
+         */
+        struct yuv_lut {
+            std::vector<uint8_t> table;
+
+            void build(const std::vector<int>& parameters);
+            uint8_t operator()(uint8_t y, uint8_t u, uint8_t v) const {
+                return table[(static_cast<size_t>(y) << 10) | (static_cast<size_t>(u >> 3) << 5) | static_cast<size_t>(v >> 3)];
+            }
+        };
+
+        static void return_hsv(const cv::Mat& img, std::vector<int> &parameters, cv::Mat& img_hls, cv::Mat& img_mask);
+        static bool yuv_planes(const cv::Mat& frame, frame_format format, cv::Mat& luma, cv::Mat& chroma);
+        static void warp_yuv(const cv::Mat& luma, const cv::Mat& chroma, const cv::Mat& M, const cv::Mat& M_chroma, cv::Size size,
+                             const std::vector<cv::Range>& bands, cv::Mat& bird_luma, cv::Mat& bird_chroma);
+        static void threshold_yuv(const cv::Mat& bird_luma, const cv::Mat& bird_chroma, const yuv_lut& lut,
+                                  const std::vector<cv::Range>& bands, cv::Mat& mask);
+        /// tuning.cpp (интерактивная настройка, только в lane_tune)
+        static void get_parameters(cv::VideoCapture& vid, std::vector<int>& parameters);
+        static  void filtered_img(const cv::Mat& img,  std::vector<std::vector<cv::Point>>& filtered_contours, point_buffer& filtered_coord,
+                                  filter_buffers& buffers, double scale = 1.0);
     };
 
 
     ///dashed_lines.cpp
-    void return_type_of_line(std::vector<int>& count_contours_in_line, std::vector<bool>& result_type_of_lines);
+    /// Штрихи и разрывы разметки вдоль линии, в строках изображения сверху.
+    struct dash_profile {
+        /// Строки, в которых линия внутри изображения
+        int rows = 0;
+        /// Строки с разметкой
+        int on_rows = 0;
+        /// Количество штрихов и разрывов
+        int dashes = 0;
+        int gaps = 0;
+        /// Самый длинный штрих и разрыв
+        int longest_dash = 0;
+        int longest_gap = 0;
+
+        /// Доля строк с разметкой (0 - линия вне изображения).
+        double duty() const {
+            return rows > 0 ? static_cast<double>(on_rows) / rows : 0.0;
+        }
+    };
+    void mask_profile(const cv::Mat& mask, const LanePoly& line, int half_width, dash_profile& profile);
+    void return_type_of_line(const std::vector<lane_polys>& history, double solid_duty, stripe_flags& result_type_of_lines);
 
     ///container.cpp
     class container {
 
     private:
-        static void check_boolean_list(std::vector<bool> &booleanList, std::vector<bool> &buffBoolList, std::vector<int> &I, int sense, size_t i);
-        static void delete_space(std::vector<TL> &container,
-                                 std::vector<int> &I, std::vector<int> &I2,
-                                 std::vector<bool> &booleanList, std::vector<bool> &buffBoolList,
+        static void check_boolean_list(bool &found, stripe_flags &buffBoolList, stripe_counters &I, int sense, size_t i);
+        static void delete_space(std::vector<lane_polys> &container,
+                                 stripe_counters &I, stripe_counters &I2,
+                                 stripe_flags &buffBoolList,
                                  size_t len, int sense );
 
 
     public:
-        std::vector<TL> contain;
+        std::vector<lane_polys> contain;
         size_t quantity_container;
         size_t quantity_stripes;
         double width_stripes;
 
         container(size_t s, size_t l, size_t img_width);
 
-        static void add_to_container(TL lines, std::vector<TL> &cont);
-        static void normalizeData(std::vector<TL> &container,
-                                  std::vector<int> &I, std::vector<bool> &buffBoolList, std::vector<int> &I2,
+        static void add_to_container(const lane_polys& lines, std::vector<lane_polys> &cont);
+        static void normalizeData(std::vector<lane_polys> &container,
+                                  stripe_counters &I, stripe_flags &buffBoolList, stripe_counters &I2,
                                   int sense);
     };
     /// draw.cpp
-    vec param_to_coord(mrpt::math::TLine2D line, size_t rows, bool Polynom);
-    void draw_lines(cv::Mat image, TL &lines, bool Polynom, std::vector<bool>& result_type_of_lines);
-    void draw_inliers(cv::Mat image, std::vector<cv::Point>& coord);
+    void param_to_coord(const LanePoly& line, size_t rows, std::vector<cv::Point>& contour);
+    void draw_lines(cv::Mat image, const lane_polys &lines, const stripe_flags& result_type_of_lines);
+    void draw_inliers(cv::Mat image, const point_buffer& coord);
+
+    ///pyramid.cpp
+    cv::Mat pyramid_matrix(const cv::Mat& M, double scale);
+    cv::Mat chroma_matrix(const cv::Mat& M);
+    void pyramid_bands(const std::vector<LanePoly>& coarse_lines, double scale, int margin, cv::Size full_size,
+                       std::vector<cv::Range>& bands);
+    void track_bands(const lane_polys& lines, int margin, cv::Size full_size, std::vector<cv::Range>& bands);
+    void warp_band(const cv::Mat& frame, const cv::Mat& M, const cv::Range& cols, cv::Mat& bird,
+                   const cv::Scalar& border = cv::Scalar());
+
+    ///sparse.cpp
+    /// Промежуточные данные разреженного front end, переиспользуемые между кадрами
+    struct sparse_buffers {
+        /// Отрезок строки кадра с разметкой [start, end)
+        struct run {
+            int row;
+            int start;
+            int end;
+        };
+        /// Первая строка трапеции и отрезки строк внутри неё
+        int top = 0;
+        std::vector<cv::Range> spans;
+        cv::Mat hls_row;
+        cv::Mat mask_row;
+        std::vector<run> runs;
+        std::vector<int> parent;
+        /// Пары {пятно, отрезок}
+        std::vector<std::pair<int, int>> order;
+        std::vector<cv::Point> outline;
+    };
+    void sparse_spans(const std::vector<int>& parametersBird, sparse_buffers& buffers);
+    void sparse_threshold(const cv::Mat& frame, const cv::Mat& chroma, std::vector<int>& parametersHSV,
+                          const hsv::yuv_lut& lut, sparse_buffers& buffers);
+    void sparse_blobs(const cv::Mat& M, cv::Size bird_size, sparse_buffers& buffers,
+                      std::vector<std::vector<cv::Point>>& filtered_contours, point_buffer& filtered_coord, cv::Mat& mask);
+
+    ///scan_lines.cpp
+    /// Ширина отрезка разметки в строке маски, пиксели (как условие ширины в filtered_img())
+    constexpr int scan_min_width = 3;
+    constexpr int scan_max_width = 50;
+    void scan_line_points(const cv::Mat& mask, const std::vector<std::vector<cv::Point>>& contours, int step, size_t budget,
+                          cv::Mat& labels, point_buffer& points);
+
+    ///static_scene.cpp
+    /// Размер сигнатуры сцены: клетки по ширине и высоте прямоугольника, описанного вокруг трапеции
+    constexpr int signature_cols = 32;
+    constexpr int signature_rows = 16;
+    void scene_signature(const cv::Mat& frame, const std::vector<int>& parametersBird, cv::Mat& small, cv::Mat& signature);
+    double signature_change(const cv::Mat& signature, const cv::Mat& reference);
 
     ///Other_func.cpp
-    void division_into_stripes(TL &lines, container &cont,std::vector<cv::Point2d>& vector_stripes_widh);
-    void rm_slanted_lines(TL &lines);
-    bool lines_found (TL& lines);
+    void division_into_stripes(const std::vector<LanePoly> &lines, container &cont,std::vector<cv::Point2d>& vector_stripes_widh,
+                               lane_polys& stripes);
+    void rm_slanted_lines(std::vector<LanePoly> &lines);
+    bool lines_found (const lane_polys& lines);
 
     ///show_all.cpp
     void cout_line(container &cont, size_t len);
-    void show_road_map(container &cont, size_t len, std::vector<bool>& result_type_of_lines);
+    void show_road_map(container &cont, size_t len, const stripe_flags& result_type_of_lines);
     void show_left_right_dist (std::vector<double>& left_right_distance);
 
     /// Ransac.cpp
-    TL RANSACLines(std::vector<cv::Point>& coords, size_t min_inliers, double DIST_THRESHOLD);
+    void RANSACLines(const point_buffer& coords, size_t min_inliers, double DIST_THRESHOLD, std::vector<LanePoly>& lines);
 
     /// simple_line_to_polynom.cpp
-    TL x_y_to_polynom(std::vector<std::vector<cv::Point>>& coord_for_lines);
-    void find_x_y(TL &lines, std::vector<std::vector<cv::Point>>& contours , double width,
-                  std::vector<std::vector<cv::Point>>& result_coord, std::vector<bool>& result_type_of_lines);
+    void x_y_to_polynom(const std::vector<point_buffer>& coord_for_lines, lane_polys& Polylines);
+    void find_x_y(const lane_polys &lines, std::vector<std::vector<cv::Point>>& contours , double width,
+                  std::vector<point_buffer>& result_coord);
+
+    /**
+     * Полином по точкам методом наименьших квадратов: col = coeffs[0] + coeffs[1]*row + coeffs[2]*row^2 + ...
+     * Coeffs - количество коэффициентов (степень + 1). При фиксированном Coeffs матрицы Eigen
+     * фиксированного размера, циклы по степеням разворачиваются компилятором. Eigen::Dynamic - запасной
+     * вариант для степени, известной только во время выполнения (размер coeffs задаёт вызывающая сторона).
+     *
+     * @param points - точки линии.
+     * @param coeffs - коэффициенты полинома по возрастанию степени.
+     * @return false, если точек меньше, чем коэффициентов, или система вырождена.
+     */
+    template <int Coeffs>
+    bool fit_polynomial(const point_buffer& points, Eigen::Matrix<double, Coeffs, 1>& coeffs) {
+        constexpr int Sums = (Coeffs == Eigen::Dynamic) ? Eigen::Dynamic : 2 * Coeffs - 1;
+        const Eigen::Index n = coeffs.size();
+        if ((n < 1) || (static_cast<Eigen::Index>(points.size()) < n))
+            return false;
+
+        // Строки нормируются на максимальную, чтобы суммы степеней не теряли точность.
+        double scale = 1;
+        for (size_t p = 0; p < points.size(); p++)
+            scale = std::max(scale, std::abs(static_cast<double>(points.rows[p])));
+
+        // Суммы степеней строк и правая часть нормальных уравнений за один проход по точкам.
+        Eigen::Matrix<double, Sums, 1> sums;
+        sums.setZero(2 * n - 1);
+        Eigen::Matrix<double, Coeffs, 1> rhs;
+        rhs.setZero(n);
+        for (size_t p = 0; p < points.size(); p++) {
+            double row = points.rows[p] / scale, col = points.cols[p];
+            double power = 1;
+            for (Eigen::Index k = 0; k < n; k++) {
+                sums[k] += power;
+                rhs[k] += power * col;
+                power *= row;
+            }
+            for (Eigen::Index k = n; k < 2 * n - 1; k++) {
+                sums[k] += power;
+                power *= row;
+            }
+        }
+
+        Eigen::Matrix<double, Coeffs, Coeffs> A;
+        A.resize(n, n);
+        for (Eigen::Index j = 0; j < n; j++)
+            for (Eigen::Index k = 0; k < n; k++)
+                A(j, k) = sums[j + k];
+        Eigen::LDLT<Eigen::Matrix<double, Coeffs, Coeffs>> solver(A);
+        // Ведущие элементы LDLT: почти нулевой - матрица вырождена (точки лежат меньше чем в Coeffs разных строках).
+        if ((solver.info() != Eigen::Success) ||
+            !(solver.vectorD().minCoeff() > 1e-12 * solver.vectorD().maxCoeff()))
+            return false;
+        coeffs = solver.solve(rhs);
+
+        // Возврат к ненормированным строкам: coeffs[k] / scale^k.
+        double power = 1;
+        for (Eigen::Index k = 0; k < n; k++) {
+            coeffs[k] /= power;
+            power *= scale;
+        }
+        return true;
+    }
 
     ///distance_to_lane.cpp
-    cv::Point return_xy_low_point(mrpt::math::TLine2D &line, int y);
-    std::vector<cv::Point> three_dots_l_r(int x1, int x2, int x3, mrpt::math::TLine2D &line);
-    void return_three_vec_point_in_img_coord (std::vector<std::vector<cv::Point>>& points);
-    cv::Point2d find_distance_point_to_center(cv::Point2d Center, cv::Point point);
-    std::vector<std::vector<cv::Point2d>>  get_three_point_vector(TL lines, const cv::Mat &image, Eigen::Matrix3d& transformationMatrix, std::vector<double>& left_right_distance);
-}
\ No newline at end of file
+    cv::Point return_xy_low_point(const LanePoly &line, int y);
+    std::vector<cv::Point> three_dots_l_r(int x1, int x2, int x3, const LanePoly &line);
+    void return_three_vec_point_in_img_coord (std::vector<std::vector<cv::Point>>& points, const cv::Mat& Minv);
+    cv::Point2d find_distance_point_to_center(cv::Point2d Center, cv::Point point, const Eigen::Matrix3d& transformationMatrix);
+    cv::Point point_to_img_coord(cv::Point point, const cv::Mat& Minv);
+    void get_three_point_vector(const lane_polys& lines, cv::Size image_size, const cv::Mat& Minv, const Eigen::Matrix3d& transformationMatrix,
+                                std::vector<double>& left_right_distance, std::vector<std::vector<cv::Point2d>>& three_points);
+
+    ///stage_profiler.cpp
+    /// Этапы обработки кадра для замера задержек.
+    enum class stage : size_t {
+        capture, change, coarse, warp, threshold, contours, ransac, stripes, association, polyfit, dashes, smoothing, distance, render, count
+    };
+    constexpr size_t stage_count = static_cast<size_t>(stage::count);
+    const char* stage_name(stage s);
+
+    /**
+     * Гистограмма задержек в стиле HDR: логарифмические группы по степеням двойки,
+     * внутри группы 32 линейных интервала (относительная погрешность ~3%).
+     * Запись и чтение lock-free, гистограмму можно читать из другого потока.
+     */
+    class latency_histogram {
+    public:
+        /// Добавляет значение, нс
+        void record(uint64_t ns);
+        uint64_t count() const;
+        uint64_t max() const;
+        /// Сумма всех значений, нс
+        uint64_t sum() const;
+        /// Значение квантиля q (0..1), нс
+        uint64_t quantile(double q) const;
+        void reset();
+
+        static size_t bucket_index(uint64_t ns);
+        static uint64_t bucket_value(size_t index);
+
+        static constexpr size_t sub_bits = 6;
+        static constexpr size_t bucket_count = 1216;
+
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> buckets{};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    ///perf_counters.cpp
+    /// Аппаратные счётчики: такты, инструкции, промахи кэша, ошибки предсказания переходов.
+    enum class perf_event_kind : size_t {
+        cycles, instructions, cache_misses, branch_misses, count
+    };
+    constexpr size_t perf_event_count = static_cast<size_t>(perf_event_kind::count);
+    typedef std::array<uint64_t, perf_event_count> perf_values;
+
+    /**
+     * Группа счётчиков perf_event_open одного потока (только пользовательский режим).
+     * Счётчики, которые ядро не поддерживает, пропускаются; без счётчика тактов группа не открывается.
+     */
+    class perf_counters {
+    public:
+        perf_counters() = default;
+        ~perf_counters();
+        perf_counters(const perf_counters&) = delete;
+        perf_counters& operator=(const perf_counters&) = delete;
+
+        /// Открывает счётчики для вызывающего потока. При ошибке error() содержит причину.
+        bool open();
+        bool is_open() const;
+        /// Поддерживается ли счётчик
+        bool supported(perf_event_kind kind) const;
+        const std::string& error() const;
+        /// Текущие значения счётчиков (неподдерживаемые - 0)
+        bool read(perf_values& values) const;
+
+        /// Счётчики текущего потока (открываются при первом обращении).
+        static perf_counters& this_thread();
+
+    private:
+        std::array<int, perf_event_count> fds{{-1, -1, -1, -1}};
+        /// Номер счётчика в порядке чтения группы
+        std::array<size_t, perf_event_count> slots{};
+        size_t opened = 0;
+        bool tried = false;
+        std::string last_error;
+    };
+
+    /// Набор гистограмм по этапам обработки кадра.
+    class stage_profiler {
+    public:
+        void record(stage s, uint64_t ns);
+        const latency_histogram& histogram(stage s) const;
+        /// Выводит p50/p90/p99/max по каждому этапу.
+        void report(std::ostream& out) const;
+        void reset();
+
+        /// Включает аппаратные счётчики по этапам. Возвращает false, если счётчики недоступны.
+        bool enable_counters();
+        bool counters_enabled() const;
+        /// Добавляет приращения счётчиков за один проход этапа.
+        void record_counters(stage s, const perf_values& delta);
+
+    private:
+        std::array<latency_histogram, stage_count> histograms;
+        std::atomic<bool> counters_on{false};
+        std::array<bool, perf_event_count> counters_supported{};
+        std::array<std::array<std::atomic<uint64_t>, perf_event_count>, stage_count> counter_sums{};
+        std::array<std::atomic<uint64_t>, stage_count> counter_samples{};
+    };
+
+    ///trace.cpp
+    /**
+     * Запись временной шкалы (начало и конец этапов по кадрам и потокам) в память
+     * с выгрузкой в формате Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+     * У каждого потока свой кольцевой буфер, при переполнении вытесняются старые события.
+     * При выключенной записи стоимость вызова - одно чтение атомарного флага.
+     */
+    class trace {
+    public:
+        /// Включает запись, events_per_thread - размер буфера каждого потока.
+        static void enable(size_t events_per_thread);
+        static void disable();
+        static bool enabled() {
+            return active.load(std::memory_order_relaxed);
+        }
+
+        /// Начало и конец интервала в текущем потоке. name должен жить до выгрузки (строковый литерал).
+        static void begin(const char* name);
+        static void end(const char* name);
+        /// Номер кадра, который обрабатывает текущий поток (добавляется к событиям).
+        static void set_frame(uint64_t frame);
+        static void set_thread_name(const std::string& name);
+
+        /// Записывает накопленные события в файл.
+        static bool dump(const std::string& path);
+
+    private:
+        static std::atomic<bool> active;
+    };
+
+    /// Интервал трассировки от создания до разрушения.
+    class trace_scope {
+    public:
+        explicit trace_scope(const char* scope_name) : name(trace::enabled() ? scope_name : nullptr) {
+            if (name != nullptr)
+                trace::begin(name);
+        }
+        ~trace_scope() {
+            if (name != nullptr)
+                trace::end(name);
+        }
+        trace_scope(const trace_scope&) = delete;
+        trace_scope& operator=(const trace_scope&) = delete;
+
+    private:
+        const char* name;
+    };
+
+    /**
+     * Таймер этапа: замеряет время от создания (или next()) до next() или разрушения.
+     * Если в профилировщике включены аппаратные счётчики, на границах этапов читаются и они.
+     * При включенной трассировке этап записывается на временную шкалу.
+     */
+    class stage_scope {
+    public:
+        stage_scope(stage_profiler& profiler, stage s)
+                : prof(profiler), current(s),
+                  counters(profiler.counters_enabled() ? &perf_counters::this_thread() : nullptr) {
+            if ((counters != nullptr) && !counters->read(counts))
+                counters = nullptr;
+            if (trace::enabled())
+                trace::begin(stage_name(current));
+            start = std::chrono::steady_clock::now();
+        }
+        ~stage_scope() {
+            finish();
+        }
+        stage_scope(const stage_scope&) = delete;
+        stage_scope& operator=(const stage_scope&) = delete;
+
+        /// Завершает текущий этап и начинает следующий.
+        void next(stage s) {
+            finish();
+            current = s;
+            if (trace::enabled())
+                trace::begin(stage_name(current));
+        }
+
+    private:
+        void finish() {
+            auto now = std::chrono::steady_clock::now();
+            if (trace::enabled())
+                trace::end(stage_name(current));
+            prof.record(current, static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()));
+            if (counters != nullptr) {
+                perf_values values;
+                if (counters->read(values)) {
+                    perf_values delta;
+                    for (size_t i = 0; i < perf_event_count; i++)
+                        delta[i] = values[i] - counts[i];
+                    prof.record_counters(current, delta);
+                    counts = values;
+                }
+            }
+            start = std::chrono::steady_clock::now();
+        }
+
+        stage_profiler& prof;
+        stage current;
+        perf_counters* counters;
+        perf_values counts{};
+        std::chrono::steady_clock::time_point start;
+    };
+
+// Таймеры этапов отключаются при сборке без LANE_STAGE_TIMERS (опция CMake).
+#ifdef LANE_STAGE_TIMERS
+#define LANE_STAGE_SCOPE(var, profiler, name) RansacNamespace::stage_scope var((profiler), RansacNamespace::stage::name)
+#define LANE_STAGE_NEXT(var, name) (var).next(RansacNamespace::stage::name)
+#else
+#define LANE_STAGE_SCOPE(var, profiler, name) ((void)0)
+#define LANE_STAGE_NEXT(var, name) ((void)0)
+#endif
+
+    ///synthetic.cpp
+    /// Параметры синтетической сцены. Размеры в пикселях изображения сверху заданы для базового кадра.
+    struct synthetic_params {
+        /// Размер кадра камеры
+        int width = 1280;
+        int height = 720;
+        /// Размер кадра, для которого заданы parametersBird в конфигурации
+        int base_width = 1280;
+        int base_height = 720;
+        /// Количество линий разметки, не больше max_stripes (крайние - сплошные, остальные - прерывистые)
+        size_t lanes = 4;
+        /// Ширина линии разметки
+        double line_width = 6;
+        /// Длина штриха и промежутка прерывистой линии
+        double dash_length = 40;
+        double dash_gap = 40;
+        /// Смещение разметки за кадр (скорость движения)
+        double speed = 6;
+        /// Максимальный коэффициент кривизны a (x = a*y^2 + b*y + c). Больше 0.0001 x_y_to_polynom не принимает.
+        double curvature = 0.00005;
+        /// Максимальное боковое смещение линий
+        double sway = 20;
+        /// Период изменения кривизны и смещения, кадры
+        double period = 300;
+        /// СКО гауссова шума, уровни яркости
+        double noise = 6;
+        /// Количество теней и ложных пятен на кадре
+        size_t shadows = 2;
+        size_t clutter = 10;
+        uint64_t seed = 1;
+    };
+
+    /**
+     * Генератор синтетических кадров дороги с известными полиномами разметки.
+     * Разметка рисуется в перспективе сверху и переводится в перспективу камеры
+     * обратной bird матрицей, масштабированной к размеру кадра.
+     */
+    class synthetic_road {
+    public:
+        synthetic_road(const settings& config, const synthetic_params& params);
+
+        /**
+         * Рисует кадр.
+         *
+         * @param frame - номер кадра (сцена детерминирована номером кадра и seed).
+         * @param out - кадр камеры (BGR).
+         * @param truth - истинные полиномы линий в координатах изображения сверху.
+         * @param solid - типы линий: true - сплошная, false - прерывистая.
+         */
+        void render(uint64_t frame, cv::Mat& out, lane_polys& truth, std::vector<bool>& solid);
+
+        /// Параметры bird преобразования, масштабированные к размеру кадра.
+        const std::vector<int>& bird_parameters() const;
+
+    private:
+        synthetic_params params;
+        std::vector<int> parametersBird;
+        std::vector<cv::Mat> matrixBird;
+        cv::Scalar paint;
+        double scale_x;
+        double scale_y;
+    };
+
+    ///quality.cpp
+    /// Параметры качества, которые меняются на ходу (LaneDetector::set_quality()).
+    struct quality_knobs {
+        /// Половина ширины полосы слежения (0 - поиск по всему изображению)
+        int roi_margin = 0;
+        /// Масштаб грубого поиска (1 - без пирамиды)
+        double pyramid_scale = 1;
+        /// Шаг строк и бюджет точек RANSAC (scan_step = 0 - точки контуров)
+        int scan_step = 0;
+        size_t scan_budget = 0;
+
+        /// Значения из параметров детекции.
+        static quality_knobs from(const settings& config);
+    };
+
+    /**
+     * Регулятор качества по времени кадра. Раз в quality_window кадров сравнивает среднее время обработки
+     * с target_frame_ms. Если кадр не укладывается, качество снижается на один шаг в той части обработки,
+     * которая заняла больше времени по таймерам этапов: подготовка изображения (слежение, затем масштаб
+     * грубого поиска) или RANSAC (точки по строкам, затем бюджет точек). Если времени остаётся больше
+     * четверти цели, шаги отменяются в обратном порядке. Каждое изменение выводится в журнал.
+     */
+    class quality_controller {
+    public:
+        explicit quality_controller(const settings& config);
+
+        /**
+         * Учитывает обработанный кадр.
+         *
+         * @param frame_seconds - время обработки кадра (используется, если таймеры этапов выключены).
+         * @param profiler - гистограммы этапов детектора.
+         * @param log - журнал изменений.
+         * @return true, если параметры качества изменились и их нужно передать детектору.
+         */
+        bool update(double frame_seconds, const stage_profiler& profiler, std::ostream& log);
+        const quality_knobs& knobs() const;
+        /// Количество действующих шагов снижения качества
+        size_t level() const;
+
+    private:
+        bool degrade(bool image_first);
+        bool degrade_image();
+        bool degrade_points();
+
+        quality_knobs current;
+        /// Параметры до каждого действующего шага снижения
+        std::vector<quality_knobs> history;
+        double target_seconds;
+        int window;
+        double min_scale;
+        size_t min_budget;
+        int roi_margin;
+        int scan_step;
+        int frames = 0;
+        double frame_seconds_sum = 0;
+        std::array<uint64_t, stage_count> stage_sums{};
+    };
+
+    ///LaneDetector.cpp
+    /**
+     * Детектор разметки. Хранит все данные между кадрами (матрицы преобразования,
+     * контейнеры предыдущих итераций, счетчики сглаживания), поэтому несколько
+     * экземпляров могут работать независимо. Не использует окна и консольный ввод.
+     */
+    class LaneDetector {
+    public:
+        /// Результат обработки одного кадра
+        struct Result {
+            /// Номер кадра
+            uint64_t frame = 0;
+            /// Полиномы текущего кадра по полосам
+            lane_polys lines{};
+            /// Полиномы после сглаживания по предыдущим кадрам
+            lane_polys smoothed{};
+            /// Тип линий по полосам: true - сплошная, false - прерывистая
+            stripe_flags types{};
+            /// Штрихи и разрывы вдоль линий текущего кадра
+            std::array<dash_profile, max_stripes> dashes{};
+            /// Расстояние до левой и правой линии, м
+            std::vector<double> left_right_distance;
+            /// Три точки левой и правой линии в мировых координатах
+            std::vector<std::vector<cv::Point2d>> three_points;
+            /// Линии обнаружены
+            bool lines_detected = false;
+            /// Сцена не изменилась: результат повторяет последний обработанный кадр (static_threshold)
+            bool reused = false;
+            /// Кадр обработан в полосах вокруг линий предыдущих кадров (слежение, roi_margin)
+            bool tracked = false;
+            /// Количество точек, переданных в RANSAC (0 при повторе результата)
+            size_t points = 0;
+            /// Изображение в перспективе сверху (только чтение: при static_threshold > 0 память общая с детектором)
+            cv::Mat bird;
+        };
+
+        /**
+         * Данные кадра после первой половины обработки: изображение сверху, маска, контуры и их точки.
+         * Не зависят от предыдущих кадров, поэтому готовятся параллельно со второй половиной.
+         */
+        struct front_data {
+            /// Номер кадра
+            uint64_t frame = 0;
+            /// Сцена не изменилась: back_end() повторяет результат последнего обработанного кадра
+            bool reused = false;
+            /// Кадр обработан в полосах слежения (track_search())
+            bool tracked = false;
+            /// Сигнатура трапеции (static_threshold > 0)
+            cv::Mat signature_small;
+            cv::Mat signature;
+            cv::Mat bird;
+            cv::Mat hls;
+            cv::Mat mask;
+            hsv::filter_buffers filter;
+            std::vector<std::vector<cv::Point>> contours;
+            /// Точки для RANSAC: точки контуров или середины отрезков по строкам (scan_step > 0)
+            point_buffer coord;
+            /// Метки контуров для выделения точек по строкам (scan_step > 0)
+            cv::Mat scan_labels;
+
+            // Кадр YUV (input_format nv12, i420): плоскости кадра и цветность сверху. bird - яркость сверху.
+            cv::Mat frame_luma;
+            cv::Mat frame_chroma;
+            cv::Mat chroma;
+            cv::Mat coarse_chroma;
+
+            /// Разреженный front end (sparse_front)
+            sparse_buffers sparse;
+
+            // Грубый поиск в уменьшенном изображении (pyramid_scale < 1).
+            cv::Mat coarse_bird;
+            cv::Mat coarse_hls;
+            cv::Mat coarse_mask;
+            hsv::filter_buffers coarse_filter;
+            std::vector<std::vector<cv::Point>> coarse_contours;
+            point_buffer coarse_coord;
+            std::vector<LanePoly> coarse_lines;
+            /// Диапазоны столбцов, обрабатываемые в полном разрешении
+            std::vector<cv::Range> bands;
+        };
+
+        explicit LaneDetector(const settings& config);
+
+        /// Обрабатывает кадр и заполняет результат (front_end() и back_end() подряд).
+        void process(const cv::Mat& frame, Result& result);
+        /**
+         * Первая половина обработки: bird преобразование, цветовой фильтр, контуры.
+         * Состояние сглаживания не использует: может выполняться в другом потоке
+         * одновременно с back_end() предыдущего кадра (но не с другим front_end()).
+         */
+        void front_end(const cv::Mat& frame, front_data& data);
+        /**
+         * Вторая половина: RANSAC, полосы, полиномы, сглаживание и расстояния.
+         * Кадры передаются строго по порядку. Изображение сверху переносится из data в result.
+         */
+        void back_end(front_data& data, Result& result);
+        /// Рисует найденные линии и расстояния поверх исходного кадра. Может вызываться одновременно с back_end().
+        void render(const cv::Mat& frame, const Result& result, cv::Mat& out);
+        /// Сбрасывает данные предыдущих кадров.
+        void reset();
+
+        const settings& config() const;
+        /// Гистограммы задержек по этапам (этапы capture и render заполняются вызывающей стороной и render()).
+        stage_profiler& profiler();
+        /// Количество кадров, для которых повторён результат неизменной сцены. Можно читать из другого потока.
+        uint64_t reused_frames() const;
+        /// Задаёт параметры качества. Можно вызывать из другого потока: применяются с начала следующего front_end().
+        void set_quality(const quality_knobs& knobs);
+
+    private:
+        void apply_quality();
+        bool static_scene(const cv::Mat& frame, front_data& data);
+        bool track_search(front_data& data);
+        bool coarse_search(const cv::Mat& frame, front_data& data);
+        void refine_bands(const cv::Mat& frame, front_data& data);
+        void refine_yuv(front_data& data);
+        void sparse_search(const cv::Mat& frame, front_data& data);
+
+        settings init;
+        stage_profiler stages;
+        std::vector<cv::Mat> matrixBird;
+        /// Матрица bird преобразования в уменьшенное изображение (режим пирамиды)
+        cv::Mat coarse_matrix;
+        /// Формат кадров и таблица порогов для YUV
+        frame_format input = frame_format::bgr;
+        /// Сообщение о кадре не того формата уже выведено (только front_end())
+        bool format_reported = false;
+        hsv::yuv_lut lut;
+        /// Матрицы bird преобразования цветности YUV (полное и уменьшенное изображение)
+        cv::Mat bird_chroma_matrix;
+        cv::Mat coarse_chroma_matrix;
+        /// Сглаженные линии последнего обработанного кадра: пишет back_end(), читает front_end()
+        std::mutex track_lock;
+        lane_polys tracked{};
+        /// Сигнатура последнего обработанного кадра и количество повторов подряд (только front_end())
+        cv::Mat scene_reference;
+        int reuse_run = 0;
+        std::atomic<uint64_t> reused_count{0};
+        /// Результат последнего обработанного кадра для повтора (только back_end())
+        Result last_result;
+        /// Параметры качества, ожидающие применения в front_end()
+        std::mutex quality_lock;
+        quality_knobs pending_quality;
+        std::atomic<bool> quality_changed{false};
+        std::vector<cv::Point2d> vec_container_stripes;
+        container cont;
+        container cont_poly;
+        stripe_counters I1{};
+        stripe_counters I2{};
+        stripe_flags buffBoolList{};
+        stripe_flags result_type_of_lines{};
+        std::vector<double> left_right_distance;
+        size_t iteration;
+        /// Номер следующего кадра (меняется только в front_end())
+        uint64_t frame_number;
+
+        // Буферы кадра: память выделяется на первых кадрах и дальше переиспользуется.
+        front_data front;
+        std::vector<LanePoly> lines;
+        lane_polys stripes{};
+        std::vector<point_buffer> coord_for_lines;
+        cv::Mat line_image;
+        cv::Mat line_warped;
+    };
+
+    ///spsc_queue (шаблон, реализация в заголовке)
+    /**
+     * Lock-free очередь на одного производителя и одного потребителя.
+     * Память выделяется один раз в конструкторе, push/pop не блокируются.
+     */
+    template<typename T>
+    class spsc_queue {
+    public:
+        explicit spsc_queue(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity + 1)
+                size <<= 1; // Ёмкость округляется до степени двойки.
+            buffer.resize(size);
+            mask = size - 1;
+        }
+
+        spsc_queue(const spsc_queue&) = delete;
+        spsc_queue& operator=(const spsc_queue&) = delete;
+
+        /// Добавляет элемент. Возвращает false, если очередь заполнена.
+        bool push(const T& item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t next = (h + 1) & mask;
+            if (next == tail.load(std::memory_order_acquire))
+                return false;
+            buffer[h] = item;
+            head.store(next, std::memory_order_release);
+            return true;
+        }
+
+        /// Извлекает элемент. Возвращает false, если очередь пуста.
+        bool pop(T& item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+            item = buffer[t];
+            tail.store((t + 1) & mask, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::vector<T> buffer;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    };
+
+    /**
+     * Ожидание условия, которое другие потоки меняют без блокировки (очередь spsc_queue, флаги).
+     * Поток спит до notify(), а не опрашивает условие: передача кадра между потоками не ждёт шага опроса.
+     */
+    class wait_signal {
+    public:
+        /// Ждёт, пока ready() не вернёт true. ready() проверяется под мьютексом сразу и после каждого notify().
+        template<typename Ready>
+        void wait(Ready ready) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, ready);
+        }
+
+        /// Будит ожидающие потоки; вызывается после изменения условия. Мьютекс берётся, чтобы изменение
+        /// между проверкой ready() и засыпанием ожидающего потока не потерялось.
+        void notify() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            changed.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable changed;
+    };
+
+    ///frame_source.cpp
+    /**
+     * Кадр во внешнем буфере (V4L2 mmap, GStreamer appsink, разделяемая память). Детектор не копирует кадр:
+     * буфер оборачивается в заголовок cv::Mat (wrap_frame()) и только читается. Пока release не вызван,
+     * буфер должен оставаться доступным.
+     */
+    struct external_frame {
+        /// Начало кадра. Для YUV плоскости идут подряд: Y, затем UV (NV12) или U и V (I420, шаг строки stride/2).
+        void* data = nullptr;
+        /// Шаг строки в байтах (для YUV - шаг строки яркости)
+        size_t stride = 0;
+        int width = 0;
+        int height = 0;
+        frame_format format = frame_format::bgr;
+        /// Время захвата кадра по часам lane_shm_now_ns() (CLOCK_MONOTONIC, как у буферов V4L2). 0 - неизвестно.
+        int64_t timestamp_ns = 0;
+        /// Возвращает буфер владельцу. Вызывается один раз, когда кадр больше не нужен (может быть пустым).
+        std::function<void()> release;
+    };
+    bool wrap_frame(const external_frame& frame, cv::Mat& out);
+    void release_frame(external_frame& frame);
+
+    /**
+     * Источник кадров для main() и lane_pipeline. next() вызывается из одного потока; кадры
+     * могут освобождаться из другого потока и в любом порядке.
+     */
+    class frame_source {
+    public:
+        virtual ~frame_source() = default;
+        /// Следующий кадр. false - кадры закончились.
+        virtual bool next(external_frame& frame) = 0;
+    };
+
+    /**
+     * Буферы кадров источника, владеющего их памятью. Буфер занят от acquire() до вызова release
+     * кадра, выданного lease(). Пул должен жить дольше выданных кадров.
+     */
+    class frame_pool {
+    public:
+        explicit frame_pool(size_t size);
+        frame_pool(const frame_pool&) = delete;
+        frame_pool& operator=(const frame_pool&) = delete;
+        /// Номер свободного буфера. Ждёт, пока внешний код освободит хотя бы один.
+        size_t acquire();
+        /// Освобождает буфер (кадр не был выдан).
+        void release(size_t i);
+        cv::Mat& buffer(size_t i);
+        /// Кадр на память буфера i (release освобождает буфер).
+        external_frame lease(size_t i, frame_format format, int64_t timestamp_ns);
+
+    private:
+        std::vector<cv::Mat> buffers;
+        std::unique_ptr<std::atomic<bool>[]> busy;
+        /// Освобождение буфера (acquire() ждёт его, когда все буферы заняты)
+        wait_signal released;
+    };
+
+    /// Кадры видеофайла или камеры через cv::VideoCapture. Кадр декодируется в буфер пула без копирования.
+    class video_source : public frame_source {
+    public:
+        /**
+         * @param name - путь к видео.
+         * @param format - формат кадров. Для YUV отключается перевод в BGR (CAP_PROP_CONVERT_RGB).
+         * @param buffers - количество буферов (кадров, одновременно удерживаемых потребителем).
+         */
+        video_source(const std::string& name, frame_format format, size_t buffers);
+        bool is_open() const;
+        bool next(external_frame& frame) override;
+        cv::VideoCapture& capture();
+
+    private:
+        cv::VideoCapture video;
+        frame_format format;
+        frame_pool pool;
+    };
+
+    /// Синтетические кадры synthetic_road в процессе (для замеров и проверки без видеофайлов).
+    class synthetic_source : public frame_source {
+    public:
+        /**
+         * @param config - параметры детекции.
+         * @param params - параметры сцены.
+         * @param frames - количество кадров.
+         * @param format - формат кадров (YUV получается переводом из BGR).
+         * @param buffers - количество буферов.
+         */
+        synthetic_source(const settings& config, const synthetic_params& params, uint64_t frames,
+                         frame_format format, size_t buffers);
+        bool next(external_frame& frame) override;
+        /// Истинные полиномы последнего выданного кадра
+        const lane_polys& truth() const;
+
+    private:
+        synthetic_road road;
+        uint64_t frames;
+        uint64_t rendered = 0;
+        frame_format format;
+        frame_pool pool;
+        cv::Mat bgr;
+        std::vector<uint8_t> interleaved;
+        lane_polys last_truth{};
+        std::vector<bool> solid;
+    };
+
+    /**
+     * Кадры, которые передаёт внешний производитель (поток захвата приложения). push() и next()
+     * вызываются из двух разных потоков, буфер возвращается производителю через release кадра.
+     */
+    class external_source : public frame_source {
+    public:
+        /// @param capacity - количество кадров в очереди.
+        explicit external_source(size_t capacity);
+        /// Передаёт кадр. false - очередь заполнена, кадр не принят и остаётся у производителя.
+        bool push(const external_frame& frame);
+        /// Кадров больше не будет: next() вернёт false, когда очередь опустеет.
+        void close();
+        /// Ждёт кадр от производителя.
+        bool next(external_frame& frame) override;
+
+    private:
+        spsc_queue<external_frame> queue;
+        std::atomic<bool> closed{false};
+        /// Новый кадр в очереди или закрытие
+        wait_signal arrived;
+    };
+
+    ///pipeline.cpp
+    /**
+     * Конвейерная обработка видео в трёх потоках: чтение кадра, первая половина обработки
+     * (LaneDetector::front_end) и вторая (LaneDetector::back_end). Пока кадр N проходит RANSAC
+     * и сглаживание, кадр N+1 переводится в перспективу сверху, а кадр N+2 читается.
+     *
+     * Кадры живут в фиксированном наборе ячеек, потоки передают номера ячеек через spsc_queue.
+     * Когда свободных ячеек нет, чтение ждёт (обратное давление), поэтому в обработке
+     * не больше depth кадров. Порядок кадров сохраняется на всех этапах.
+     */
+    class lane_pipeline {
+    public:
+        /// Кадр в конвейере
+        struct slot {
+            /// Кадр источника (буфер возвращается источнику при release())
+            external_frame input;
+            /// Исходный кадр: заголовок на память input
+            cv::Mat frame;
+            LaneDetector::front_data front;
+            LaneDetector::Result result;
+            /// Время захвата кадра (lane_shm_now_ns): метка источника или время чтения, если её нет
+            int64_t capture_ns = 0;
+            /// Начало чтения кадра (от него считается задержка)
+            std::chrono::steady_clock::time_point start;
+            /// Время front_end() и back_end() кадра, без ожидания в очередях
+            std::chrono::steady_clock::duration processing{};
+        };
+
+        /**
+         * Запускает потоки.
+         *
+         * @param detector - детектор. Пока конвейер работает, process() и reset() вызывать нельзя, render() - можно.
+         * @param source - источник кадров. Источник с собственными буферами должен иметь их больше depth;
+         *                 external_source перед stop() закрывается (close()), иначе чтение ждёт кадр.
+         * @param depth - количество кадров в обработке одновременно (не меньше 3).
+         */
+        lane_pipeline(LaneDetector& detector, frame_source& source, size_t depth);
+        /// Останавливает потоки (кадры в обработке отбрасываются).
+        ~lane_pipeline();
+
+        lane_pipeline(const lane_pipeline&) = delete;
+        lane_pipeline& operator=(const lane_pipeline&) = delete;
+
+        /// Следующий обработанный кадр по порядку. Ждёт, пока кадр готов; nullptr - видео закончилось.
+        slot* next();
+        /// Возвращает ячейку кадра, полученного из next(), для чтения следующих кадров.
+        void release(slot* s);
+        /// Останавливает потоки и возвращает источнику кадры, оставшиеся в ячейках.
+        void stop();
+
+        /// Задержка кадра от начала чтения до готовности результата
+        const latency_histogram& latency() const;
+        /// Выводит пропускную способность и задержку кадра.
+        void report(std::ostream& out) const;
+
+    private:
+        void decode_loop();
+        void front_loop();
+        void back_loop();
+        bool wait_pop(spsc_queue<size_t>& queue, wait_signal& signal, size_t& item, const std::atomic<bool>* upstream_finished);
+
+        LaneDetector& detector;
+        frame_source& source;
+        std::vector<slot> slots;
+        spsc_queue<size_t> free_slots;
+        spsc_queue<size_t> decoded;
+        spsc_queue<size_t> prepared;
+        spsc_queue<size_t> done;
+        /// Элемент в очереди того же названия, завершение предыдущего этапа или остановка
+        wait_signal free_ready;
+        wait_signal decoded_ready;
+        wait_signal prepared_ready;
+        wait_signal done_ready;
+        std::atomic<bool> running{true};
+        std::atomic<bool> decode_finished{false};
+        std::atomic<bool> front_finished{false};
+        std::atomic<bool> back_finished{false};
+        latency_histogram frame_latency;
+        std::chrono::steady_clock::time_point started;
+        std::atomic<int64_t> last_done_ns{0};
+        std::thread decoder;
+        std::thread front_worker;
+        std::thread back_worker;
+    };
+
+    ///telemetry.cpp
+    /// Максимальное количество полос в записи телеметрии.
+    constexpr size_t telemetry_max_stripes = max_stripes;
+
+    /// Запись телеметрии одного кадра. POD-структура, копируется в очередь без аллокаций.
+    struct frame_record {
+        /// Номер кадра
+        uint64_t frame;
+        /// Время формирования записи (steady_clock), нс
+        int64_t timestamp_ns;
+        /// Количество заполненных полос
+        uint32_t stripes;
+        /// 1 - линии обнаружены
+        uint8_t lines_detected;
+        /// Тип линии по полосам: 1 - сплошная, 0 - прерывистая
+        uint8_t solid[telemetry_max_stripes];
+        /// Коэффициенты полиномов [a, b, c] по полосам
+        double coefs[telemetry_max_stripes][3];
+        /// Расстояние до левой и правой линии, м
+        double distance[2];
+        /// Три точки левой и правой линии (x, y)
+        double three_points[2][3][2];
+        /// Время обработки кадра, с
+        double frame_time;
+    };
+
+    void fill_frame_record(frame_record& rec, uint64_t frame, const lane_polys& lines, const stripe_flags& result_type_of_lines,
+                           bool lines_detected, const std::vector<double>& left_right_distance,
+                           const std::vector<std::vector<cv::Point2d>>& three_points, double frame_time);
+    void fill_shm_frame(lane_shm_frame& out, const frame_record& rec, int64_t capture_ns);
+
+    /// Кодировщик записей телеметрии. Реализации: JSON-lines, CSV, двоичный.
+    class telemetry_encoder {
+    public:
+        virtual ~telemetry_encoder() = default;
+        /// Заголовок потока (записывается один раз перед первой записью)
+        virtual void header(std::string& out);
+        virtual void encode(const frame_record& rec, std::string& out) = 0;
+        /// Открывать ли файл в двоичном режиме
+        virtual bool binary() const;
+
+        static std::unique_ptr<telemetry_encoder> create(const std::string& format);
+    };
+
+    class json_lines_encoder : public telemetry_encoder {
+    public:
+        void encode(const frame_record& rec, std::string& out) override;
+    };
+
+    class csv_encoder : public telemetry_encoder {
+    public:
+        void header(std::string& out) override;
+        void encode(const frame_record& rec, std::string& out) override;
+    };
+
+    class binary_encoder : public telemetry_encoder {
+    public:
+        void header(std::string& out) override;
+        void encode(const frame_record& rec, std::string& out) override;
+        bool binary() const override;
+    };
+
+    /**
+     * Асинхронная запись телеметрии. Цикл обработки только копирует запись в очередь,
+     * форматирование и вывод выполняются в фоновом потоке.
+     */
+    class telemetry {
+    public:
+        telemetry(std::unique_ptr<telemetry_encoder> enc, const std::string& path, double rate_hz, size_t queue_size);
+        ~telemetry();
+
+        telemetry(const telemetry&) = delete;
+        telemetry& operator=(const telemetry&) = delete;
+
+        bool publish(const frame_record& rec);
+        /// Количество записей, потерянных из-за переполнения очереди
+        size_t dropped() const;
+        /// Количество записей, пропущенных ограничением частоты
+        size_t skipped() const;
+
+    private:
+        void run();
+
+        std::unique_ptr<telemetry_encoder> encoder;
+        spsc_queue<frame_record> queue;
+        FILE *out;
+        int64_t min_interval_ns;
+        int64_t last_timestamp_ns;
+        std::atomic<bool> running;
+        std::atomic<size_t> dropped_count;
+        size_t skipped_count;
+        std::thread writer;
+    };
+
+    ///offline.cpp
+    /**
+     * Офлайн обработка одного видео по частям: видео делится на chunks диапазонов кадров, каждый
+     * обрабатывается в своём потоке своим детектором. Часть начинается на warmup кадров раньше своего
+     * диапазона: эти кадры только накапливают сглаживание (контейнеры, счётчики) и в результат не попадают.
+     */
+    struct offline_options {
+        /// Количество частей (потоков), не больше количества ядер
+        size_t chunks = 1;
+        /// Кадров перекрытия перед началом части
+        size_t warmup = 30;
+        /// Обработать не больше стольких кадров (0 - всё видео)
+        size_t max_frames = 0;
+    };
+
+    /// Статистика офлайн обработки
+    struct offline_stats {
+        /// Кадров в результате
+        size_t frames = 0;
+        /// Частей (потоков), на которые разделено видео
+        size_t chunks = 0;
+        /// Кадров, обработанных повторно для перекрытия
+        size_t warmup_frames = 0;
+        /// Время обработки, с
+        double seconds = 0;
+    };
+
+    bool process_offline(const settings& init, const offline_options& options,
+                         const std::function<void(const frame_record&)>& output, offline_stats& stats);
+
+    ///metrics.cpp
+    /**
+     * Счётчики детектора для метрик в формате Prometheus. record() вызывает поток, получающий результаты
+     * кадров (несколько атомарных записей на кадр), expose() - поток metrics_server. Блокировок нет:
+     * гистограммы этапов читаются из profiler() детектора, как при выводе report().
+     */
+    class lane_metrics {
+    public:
+        explicit lane_metrics(LaneDetector& detector);
+
+        /// Учитывает результат кадра.
+        void record(const LaneDetector::Result& result);
+        /// Уровень регулятора качества (quality_controller::level()).
+        void set_quality_level(size_t level);
+        /// Количество записей телеметрии, потерянных из-за переполнения очереди (telemetry::dropped()).
+        void set_dropped(uint64_t records);
+        /// Текст метрик в формате Prometheus text exposition 0.0.4.
+        void expose(std::string& out) const;
+
+    private:
+        LaneDetector& detector;
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> frames_with_lines{0};
+        std::atomic<uint64_t> tracked_frames{0};
+        std::atomic<uint64_t> points_total{0};
+        std::atomic<uint64_t> stripes_total{0};
+        std::atomic<uint64_t> empty_stripes_total{0};
+        std::atomic<uint64_t> dropped_records{0};
+        /// Время последнего кадра и сглаженный интервал между кадрами, нс (для кадров в секунду)
+        std::atomic<int64_t> last_frame_ns{0};
+        std::atomic<int64_t> frame_interval_ns{0};
+        /// Состояние последнего кадра
+        std::atomic<uint32_t> lines_detected{0};
+        std::atomic<uint32_t> lines_tracked{0};
+        std::atomic<uint32_t> quality_level{0};
+        /// Точки RANSAC на кадр
+        latency_histogram points;
+    };
+
+    /**
+     * HTTP сервер метрик на 127.0.0.1 (GET /metrics) в отдельном потоке. Соединения обслуживаются
+     * по одному: ответ формируется из lane_metrics и не задерживает обработку кадров.
+     */
+    class metrics_server {
+    public:
+        /// port 0 - свободный порт, выбранный системой (см. port()).
+        metrics_server(const lane_metrics& source, uint16_t port);
+        ~metrics_server();
+
+        metrics_server(const metrics_server&) = delete;
+        metrics_server& operator=(const metrics_server&) = delete;
+
+        bool is_open() const;
+        uint16_t port() const;
+        /// Количество обслуженных запросов
+        uint64_t requests() const;
+
+    private:
+        void run();
+        void serve(int client);
+
+        const lane_metrics& metrics;
+        int listener = -1;
+        uint16_t bound_port = 0;
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> served{0};
+        std::string body;
+        std::thread worker;
+    };
+
+    bool scrape_metrics(uint16_t port, std::string& body);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * Публикация результатов детекции в разделяемую память POSIX.
+ *
+ * Сегмент содержит заголовок и кольцо слотов. Каждый слот защищён seqlock:
+ * писатель никогда не ждёт читателей, читатель повторяет чтение, если слот
+ * был перезаписан во время копирования. Заголовок не зависит от OpenCV и mrpt,
+ * поэтому читатель подключается к внешним процессам отдельно (библиотека lane_shm).
+ */
+namespace RansacNamespace {
+
+    constexpr uint32_t lane_shm_magic = 0x454e414c; // "LANE"
+    constexpr uint32_t lane_shm_version = 1;
+    constexpr size_t lane_shm_max_stripes = 8;
+
+    /// Модель полос одного кадра. Размер кратен 8 байтам (копируется словами).
+    struct lane_shm_frame {
+        /// Порядковый номер публикации (начиная с 1)
+        uint64_t sequence;
+        /// Номер кадра
+        uint64_t frame;
+        /// Время получения кадра (CLOCK_MONOTONIC), нс
+        int64_t capture_ns;
+        /// Время публикации (CLOCK_MONOTONIC), нс
+        int64_t publish_ns;
+        /// Количество заполненных полос
+        uint32_t stripes;
+        /// 1 - линии обнаружены
+        uint32_t lines_detected;
+        /// Тип линии по полосам: 1 - сплошная, 0 - прерывистая
+        uint8_t solid[lane_shm_max_stripes];
+        /// Коэффициенты полиномов x = a*y^2 + b*y + c по полосам
+        double coefs[lane_shm_max_stripes][3];
+        /// Расстояние до левой и правой линии, м
+        double distance[2];
+    };
+
+    static_assert(sizeof(lane_shm_frame) % sizeof(uint64_t) == 0, "lane_shm_frame must be a multiple of 8 bytes");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory requires lock-free 64-bit atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory requires lock-free 32-bit atomics");
+
+    constexpr size_t lane_shm_words = sizeof(lane_shm_frame) / sizeof(uint64_t);
+
+    /// Слот кольца: seq чётный - данные целы (seq / 2 - номер публикации), нечётный - идёт запись.
+    struct alignas(64) lane_shm_slot {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> words[lane_shm_words];
+    };
+
+    struct alignas(64) lane_shm_header {
+        /// Записывается последним (release): читатель проверяет его первым (acquire)
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t slot_size;
+        /// Номер последней завершённой публикации (0 - публикаций не было)
+        std::atomic<uint64_t> write_seq;
+    };
+
+    /// Текущее время CLOCK_MONOTONIC в наносекундах (совпадает между процессами).
+    int64_t lane_shm_now_ns();
+
+    /// Публикатор: создаёт сегмент и пишет кадры. Один писатель на сегмент.
+    class lane_shm_publisher {
+    public:
+        lane_shm_publisher() = default;
+        ~lane_shm_publisher();
+
+        lane_shm_publisher(const lane_shm_publisher&) = delete;
+        lane_shm_publisher& operator=(const lane_shm_publisher&) = delete;
+
+        bool open(const std::string& name, uint32_t capacity);
+        void close();
+        bool is_open() const;
+        /// Записывает кадр в очередной слот. Поля sequence и publish_ns заполняются здесь.
+        void publish(lane_shm_frame& frame);
+
+    private:
+        std::string shm_name;
+        size_t map_size = 0;
+        void *base = nullptr;
+        lane_shm_header *header = nullptr;
+        lane_shm_slot *slots = nullptr;
+        uint64_t next_seq = 1;
+    };
+
+    /// Читатель: подключается к существующему сегменту, ничего в него не пишет.
+    class lane_shm_reader {
+    public:
+        lane_shm_reader() = default;
+        ~lane_shm_reader();
+
+        lane_shm_reader(const lane_shm_reader&) = delete;
+        lane_shm_reader& operator=(const lane_shm_reader&) = delete;
+
+        bool open(const std::string& name);
+        void close();
+        bool is_open() const;
+        /// Номер последней завершённой публикации (0 - публикаций не было)
+        uint64_t last_sequence() const;
+        /// Читает последний опубликованный кадр. false - публикаций ещё не было.
+        bool read_latest(lane_shm_frame& out) const;
+        /// Читает кадр по номеру: 1 - прочитан, 0 - ещё не опубликован, -1 - уже перезаписан.
+        int read(uint64_t sequence, lane_shm_frame& out) const;
+
+    private:
+        size_t map_size = 0;
+        void *base = nullptr;
+        const lane_shm_header *header = nullptr;
+        const lane_shm_slot *slots = nullptr;
+    };
+}
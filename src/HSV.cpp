@@ -8,9 +8,10 @@ namespace RansacNamespace {
  *
  * @param img - входное изображение, к которому применяется цветовой фильтр.
  * @param parameters - вектор параметров цветового фильтра [h1, s1, v1, h2, s2, v2].
- * @return Изображение в полутоновом формате, после применения цветового фильтра.
+ * @param img_hls - буфер изображения в цветовом пространстве HLS.
+ * @param img_mask - изображение в полутоновом формате после применения цветового фильтра.
  */
-    cv::Mat hsv::return_hsv(const cv::Mat& img, std::vector<int> &parameters) {
+    void hsv::return_hsv(const cv::Mat& img, std::vector<int> &parameters, cv::Mat& img_hls, cv::Mat& img_mask) {
 
         // Извлекаем параметры цветового фильтра из входного вектора.
         int h1 = parameters[0],
@@ -25,14 +26,10 @@ namespace RansacNamespace {
         cv::Scalar h_max = cv::Scalar(h2, s2, v2);
 
         // Преобразуем входное изображение в HSV-цветовое пространство.
-        cv::Mat img_hsv, hsv;
-        cv::cvtColor(img, hsv, cv::COLOR_BGR2HLS);
+        cv::cvtColor(img, img_hls, cv::COLOR_BGR2HLS);
 
         // Применяем цветовой фильтр с учетом минимальных и максимальных значений HSV.
-        cv::inRange(hsv, h_min, h_max, img_hsv);
-
-        // Возвращаем полутоновое изображение после применения цветового фильтра.
-        return img_hsv;
+        cv::inRange(img_hls, h_min, h_max, img_mask);
     }
 
 
@@ -44,153 +41,218 @@ namespace RansacNamespace {
  * filtered_img - функция для обработки и фильтрации контуров на изображении.
  *
  * @param img - входное изображение для обработки.
- * @param filtered_contours - вектор, в который будут добавлены отфильтрованные контуры.
- * @param filtered_coord - вектор, в который будут добавлены координаты точек отфильтрованных контуров.
+ * @param filtered_contours - вектор, в который будут записаны отфильтрованные контуры.
+ * @param filtered_coord - буфер, в который будут записаны координаты точек отфильтрованных контуров.
+ * @param buffers - промежуточные данные (ядро, результат эрозии, все найденные контуры).
+ * @param scale - масштаб изображения относительно полного разрешения: размеры ядра и пороги контуров умножаются на него.
  */
-    void hsv::filtered_img(const cv::Mat& img, std::vector<std::vector<cv::Point>>& filtered_contours, std::vector<cv::Point>& filtered_coord) {
-        // Создание нескольких вспомогательных матриц для обработки изображения.
-        cv::Mat thresh, img_result;
-
-        // Копирование входного изображения в матрицу "thresh".
-        thresh = img;
-        img_result = img;
-
+    void hsv::filtered_img(const cv::Mat& img, std::vector<std::vector<cv::Point>>& filtered_contours, point_buffer& filtered_coord,
+                           filter_buffers& buffers, double scale) {
         // Создание ядра для морфологической операции закрытия (закрытие областей).
-        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(1, 10));
-        cv::erode(thresh, img_result, kernel);
+        // Ядро строится заново при смене масштаба (регулятор качества меняет pyramid_scale), как и пороги ниже.
+        if (buffers.kernel.empty() || (std::abs(buffers.kernel_scale - scale) > 1e-9)) {
+            buffers.kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(1, std::max(1, static_cast<int>(std::lround(10 * scale)))));
+            buffers.kernel_scale = scale;
+        }
+        cv::erode(img, buffers.eroded, buffers.kernel);
 
         // Поиск контуров на обработанном изображении.
-        std::vector<std::vector<cv::Point>> contours;
-        std::vector<cv::Vec4i> hierarchy;
-        cv::findContours(img_result, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        cv::findContours(buffers.eroded, buffers.contours, buffers.hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
 
         // Фильтрация контуров на основе их размеров и формы.
-        for (const auto &cnt: contours) {
+        // Подходящие контуры не копируются, а обмениваются с элементами filtered_contours.
+        size_t kept = 0;
+        for (auto &cnt: buffers.contours) {
             cv::Rect boundingRect = cv::boundingRect(cnt);
             int w = boundingRect.width;
             int h = boundingRect.height;
             double Area = cv::contourArea(cnt, true);
             // Условия для фильтрации контуров.
-            if (((h > w * 5) || ((h > 30) && (h < 100))) && ((w < 50) && (w > 3)) && (Area < 700)) {
-                filtered_contours.push_back(cnt);
-                filtered_coord.insert(filtered_coord.begin(), cnt.begin(), cnt.end());
+            if (((h > w * 5) || ((h > 30 * scale) && (h < 100 * scale))) && ((w < 50 * scale) && (w > 3 * scale)) &&
+                (Area < 700 * scale * scale)) {
+                if (kept == filtered_contours.size())
+                    filtered_contours.emplace_back();
+                filtered_contours[kept++].swap(cnt);
             }
         }
+        filtered_contours.resize(kept);
+
+        // Точки контуров в обратном порядке контуров (тот же порядок, что и при вставке каждого контура в начало).
+        filtered_coord.clear();
+        for (size_t i = kept; i-- > 0;)
+            filtered_coord.append(filtered_contours[i]);
     }
 
 
 
-/**
- * Функция для изменения параметров HSV-фильтрации.
- * Пользователь может настроить значения параметров HSV для фильтрации цветов на изображении.
- * Значения могут быть изменены с использованием ползунков на окне настроек.
- * Результаты настройки могут быть сохранены в файле "hsv_params.txt".
- */
-    void hsv::get_parameters(const std::string& video_name) {
-        std::cout << "Хотите изменить параметры HSV? (y/n) ";
-        char ans;
-        int check;
-        std::cin >> ans;
-
-        // Инициализация параметров HSV: h1, s1, v1, h2, s2, v2.
-        int parameters[6] = {0, 0, 0, 255, 255, 255};
-        std::string names[6] = {"h1", "s1", "v1", "h2", "s2", "v2"};
-        FILE *f;
-
-        if (ans == 'y') {
-            // Блок выполнится, если пользователь хочет изменить параметры.
-
-            cv::Scalar h_max, h_min;
-            f = fopen("../data/hsv_params.txt", "r");
-            for (int i = 0; i < 6; i++) {
-                check = fscanf(f, " %d", parameters + i);
-            }
+    namespace {
 
-            if (check > 0) {
-                fclose(f);
-            }
+        /// Полоса, выровненная по чётному столбцу: одна пара цветности на два столбца яркости.
+        cv::Range even_band(const cv::Range& band) {
+            return {band.start & ~1, band.end};
+        }
 
-            cv::VideoCapture vid(video_name);
-            if (!vid.isOpened()) {
-                std::cout << "Ошибка: не удалось открыть камеру." << std::endl;
-            }
-            cv::namedWindow("result");
-            cv::namedWindow("settings");
+        /// Столбцы цветности для полосы яркости.
+        cv::Range chroma_band(const cv::Range& band, int chroma_cols) {
+            return {band.start / 2, std::min(chroma_cols, (band.end + 1) / 2)};
+        }
 
-            // Создание ползунков для настройки параметров.
-            for (int i = 0; i < 6; i++) {
-                cv::createTrackbar(names[i], "settings", &parameters[i], 255, nullptr);
+        /// Порог по таблице для одного участка: цветность - с половинным разрешением.
+        void lut_threshold(const cv::Mat& luma, const cv::Mat& chroma, const hsv::yuv_lut& lut, cv::Mat& mask) {
+            for (int r = 0; r < luma.rows; r++) {
+                const uint8_t *y = luma.ptr<uint8_t>(r);
+                const uint8_t *uv = chroma.ptr<uint8_t>(r / 2);
+                uint8_t *m = mask.ptr<uint8_t>(r);
+                for (int c = 0; c < luma.cols; c++) {
+                    size_t k = 2 * static_cast<size_t>(c / 2);
+                    m[c] = lut(y[c], uv[k], uv[k + 1]);
+                }
             }
+        }
+    }
 
-            while (cv::waitKey(1) != 'w') {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                cv::Mat img;
-                vid.read(img);
-                cv::Mat hsv;
-                cv::cvtColor(img, hsv, cv::COLOR_BGR2HLS);
-                cv::waitKey(0);
-                // Получение текущих значений параметров HSV.
-                int h1 = cv::getTrackbarPos("h1", "settings");
-                int s1 = cv::getTrackbarPos("s1", "settings");
-                int v1 = cv::getTrackbarPos("v1", "settings");
-                int h2 = cv::getTrackbarPos("h2", "settings");
-                int s2 = cv::getTrackbarPos("s2", "settings");
-                int v2 = cv::getTrackbarPos("v2", "settings");
-
-                // Обновление массива параметров.
-                parameters[0] = h1;
-                parameters[1] = s1;
-                parameters[2] = v1;
-                parameters[3] = h2;
-                parameters[4] = s2;
-                parameters[5] = v2;
-
-                h_min = cv::Scalar(h1, s1, v1);
-                h_max = cv::Scalar(h2, s2, v2);
-
-                cv::Mat img_hsv;
-                cv::imshow("r", img);
-                cv::inRange(hsv, h_min, h_max, img_hsv);
-                cv::imshow("result", img_hsv);
-                f = fopen("../data/hsv_params.txt", "w");
-                for (int parameter : parameters) {
-                    fprintf(f, " %d", parameter);
-                }
-                fclose(f);
+/**
+ * parse_frame_format - формат кадра по названию ("bgr", "nv12", "i420").
+ *
+ * @return false, если название неизвестно.
+ */
+    bool parse_frame_format(const std::string& name, frame_format& format) {
+        if (name == "bgr")
+            format = frame_format::bgr;
+        else if (name == "nv12")
+            format = frame_format::nv12;
+        else if (name == "i420")
+            format = frame_format::i420;
+        else
+            return false;
+        return true;
+    }
+
+/**
+ * Строит таблицу: для каждого сочетания Y и квантованных U, V - результат return_hsv()
+ * для цвета, в который OpenCV переводит этот YUV (cv::COLOR_YUV2BGR_NV12, BT.601).
+ * Все сочетания собираются в одно изображение NV12 (блок 2x2 яркости на пару цветности)
+ * и переводятся теми же функциями, что и кадр в режиме BGR.
+ *
+ * @param parameters - параметры цветового фильтра [h1, s1, v1, h2, s2, v2].
+ */
+    void hsv::yuv_lut::build(const std::vector<int>& parameters) {
+        const int side = 512; // 512 x 512 блоков = 256 * 32 * 32 сочетаний
+        cv::Mat nv12(side * 3, side * 2, CV_8UC1);
+        for (int b = 0; b < side * side; b++) {
+            int by = b / side, bx = b % side;
+            auto y = static_cast<uint8_t>(b >> 10);
+            // Центр интервала квантования цветности.
+            auto u = static_cast<uint8_t>((((b >> 5) & 31) << 3) + 4);
+            auto v = static_cast<uint8_t>(((b & 31) << 3) + 4);
+            for (int dy = 0; dy < 2; dy++) {
+                uint8_t *row = nv12.ptr<uint8_t>(2 * by + dy);
+                row[2 * bx] = y;
+                row[2 * bx + 1] = y;
             }
+            uint8_t *uv = nv12.ptr<uint8_t>(2 * side + by);
+            uv[2 * bx] = u;
+            uv[2 * bx + 1] = v;
+        }
 
-            // Сохранение параметров в файле "hsv_params.txt".
+        cv::Mat bgr, hls, mask;
+        cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+        std::vector<int> params = parameters;
+        return_hsv(bgr, params, hls, mask);
 
+        table.resize(static_cast<size_t>(side * side));
+        for (int b = 0; b < side * side; b++)
+            table[static_cast<size_t>(b)] = mask.at<uint8_t>(2 * (b / side), 2 * (b % side));
+    }
 
-            vid.release();
-            cv::destroyAllWindows();
+/**
+ * yuv_planes - плоскости кадра YUV 4:2:0 (одноканальное изображение высотой 3/2 кадра).
+ *
+ * @param frame - кадр NV12 или I420.
+ * @param format - формат кадра.
+ * @param luma - яркость (заголовок на память кадра).
+ * @param chroma - цветность (U, V) с половинным разрешением, CV_8UC2. Для NV12 - заголовок на память кадра,
+ *                 для I420 плоскости U и V объединяются в этот буфер.
+ * @return false, если размер или тип кадра не соответствуют формату (сообщение выводит вызывающая сторона).
+ */
+    bool hsv::yuv_planes(const cv::Mat& frame, frame_format format, cv::Mat& luma, cv::Mat& chroma) {
+        if ((frame.type() != CV_8UC1) || (frame.rows % 3 != 0) || (frame.cols % 2 != 0) || (frame.step % 2 != 0) ||
+            (format == frame_format::bgr))
+            return false;
+        int h = frame.rows / 3 * 2, w = frame.cols;
+        luma = frame.rowRange(0, h);
+        // Плоскости цветности начинаются сразу после яркости.
+        auto *planes = const_cast<uint8_t*>(frame.ptr<uint8_t>(h));
+        if (format == frame_format::nv12) {
+            chroma = cv::Mat(h / 2, w / 2, CV_8UC2, planes, frame.step);
         } else {
-            // В противном случае параметры фильтрации загружаются из файла.
-            f = fopen("../data/hsv_params.txt", "r");
-            for (int i = 0; i < 6; i++) {
-                check = fscanf(f, " %d", parameters + i);
-            }
-            if (check > 0) {
-                fclose(f);
-            }
+            // Шаг строки плоскостей U и V - половина шага яркости (буферы с выравниванием строк).
+            size_t plane = static_cast<size_t>(h / 2) * (frame.step / 2);
+            cv::Mat u(h / 2, w / 2, CV_8UC1, planes, frame.step / 2);
+            cv::Mat v(h / 2, w / 2, CV_8UC1, planes + plane, frame.step / 2);
+            cv::merge(std::vector<cv::Mat>{u, v}, chroma);
         }
+        return true;
+    }
 
-        // Вывод на экран текущих значений параметров HSV.
-        std::cout << "\nВаши параметры HSV: \n\n";
-        std::cout << "Минимальные: ";
-        std::cout << " h: " << parameters[0];
-        std::cout << " s: " << parameters[1];
-        std::cout << " v: " << parameters[2];
-        std::cout << "\nМаксимальные: ";
-        std::cout << " h: " << parameters[3];
-        std::cout << " s: " << parameters[4];
-        std::cout << " v: " << parameters[5];
-        std::cout << "\n\n";
+/**
+ * warp_yuv - bird преобразование плоскостей YUV: яркость в размер size, цветность - в половинный размер.
+ * Если заданы полосы столбцов, преобразуются только они (с чётного столбца), остальное - чёрный цвет (Y = 0, U = V = 128).
+ *
+ * @param luma - яркость кадра.
+ * @param chroma - цветность кадра (CV_8UC2, половинное разрешение).
+ * @param M - матрица преобразования яркости.
+ * @param M_chroma - матрица преобразования цветности (chroma_matrix(M)).
+ * @param size - размер изображения сверху.
+ * @param bands - полосы столбцов (пустой вектор - изображение целиком).
+ * @param bird_luma - яркость сверху.
+ * @param bird_chroma - цветность сверху.
+ */
+    void hsv::warp_yuv(const cv::Mat& luma, const cv::Mat& chroma, const cv::Mat& M, const cv::Mat& M_chroma, cv::Size size,
+                       const std::vector<cv::Range>& bands, cv::Mat& bird_luma, cv::Mat& bird_chroma) {
+        cv::Size chroma_size((size.width + 1) / 2, (size.height + 1) / 2);
+        // За пределами кадра - чёрный цвет, как у изображения BGR: Y = 0, U = V = 128.
+        cv::Scalar neutral(128, 128);
+        if (bands.empty()) {
+            cv::warpPerspective(luma, bird_luma, M, size);
+            cv::warpPerspective(chroma, bird_chroma, M_chroma, chroma_size, cv::INTER_LINEAR, cv::BORDER_CONSTANT, neutral);
+            return;
+        }
+        bird_luma.create(size, CV_8UC1);
+        bird_luma.setTo(cv::Scalar::all(0));
+        bird_chroma.create(chroma_size, CV_8UC2);
+        bird_chroma.setTo(neutral); // Вне полос - чёрный цвет, как у bird_luma и у bird в refine_bands.
+        for (auto &band : bands) {
+            cv::Range cols = even_band(band);
+            warp_band(luma, M, cols, bird_luma);
+            warp_band(chroma, M_chroma, chroma_band(cols, chroma_size.width), bird_chroma, neutral);
+        }
     }
 
+/**
+ * threshold_yuv - маска разметки по таблице yuv_lut без перевода в BGR и HLS.
+ *
+ * @param bird_luma - яркость сверху.
+ * @param bird_chroma - цветность сверху (половинное разрешение).
+ * @param lut - таблица порогов.
+ * @param bands - полосы столбцов (пустой вектор - изображение целиком), вне полос маска нулевая.
+ * @param mask - маска.
+ */
+    void hsv::threshold_yuv(const cv::Mat& bird_luma, const cv::Mat& bird_chroma, const yuv_lut& lut,
+                            const std::vector<cv::Range>& bands, cv::Mat& mask) {
+        mask.create(bird_luma.size(), CV_8UC1);
+        if (bands.empty()) {
+            lut_threshold(bird_luma, bird_chroma, lut, mask);
+            return;
+        }
+        mask.setTo(cv::Scalar::all(0));
+        for (auto &band : bands) {
+            cv::Range cols = even_band(band);
+            cv::Range uv = chroma_band(cols, bird_chroma.cols);
+            cv::Mat mask_band = mask.colRange(cols.start, cols.end);
+            lut_threshold(bird_luma.colRange(cols.start, cols.end), bird_chroma.colRange(uv.start, uv.end), lut, mask_band);
+        }
+    }
 
 
 }
-
-
-
@@ -0,0 +1,447 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+    namespace {
+
+        /// Копирует результат кадра, кроме номера и изображения сверху.
+        void copy_values(const LaneDetector::Result& from, LaneDetector::Result& to) {
+            to.lines = from.lines;
+            to.smoothed = from.smoothed;
+            to.types = from.types;
+            to.dashes = from.dashes;
+            to.left_right_distance = from.left_right_distance;
+            to.three_points = from.three_points;
+            to.lines_detected = from.lines_detected;
+        }
+    }
+
+/**
+ * Конструктор детектора.
+ *
+ * @param config - параметры детекции. Копируются в детектор, внешний объект после этого не используется.
+ */
+    LaneDetector::LaneDetector(const settings& config)
+            : init(config),
+              cont(config.cout_containers, config.cout_stripes, static_cast<size_t>(config.parametersBird[9])),
+              cont_poly(config.cout_containers, config.cout_stripes, static_cast<size_t>(config.parametersBird[9])) {
+        // Матрицы преобразования в птичью перспективу не меняются между кадрами.
+        matrixBird = Bird_view::return_bird_matrix(init.parametersBird);
+        if (init.pyramid_scale < 1)
+            coarse_matrix = pyramid_matrix(matrixBird[0], init.pyramid_scale);
+        // Для кадров YUV пороги переводятся в таблицу один раз.
+        if (parse_frame_format(init.input_format, input) && (input != frame_format::bgr)) {
+            lut.build(init.parametersHSV);
+            bird_chroma_matrix = chroma_matrix(matrixBird[0]);
+            if (init.pyramid_scale < 1)
+                coarse_chroma_matrix = chroma_matrix(coarse_matrix);
+        }
+        // Вектор, определяющий ширину полос, на которые делится изображение.
+        vec_container_stripes = init.get_vector_stripes_width(cont.width_stripes);
+        reset();
+    }
+
+/**
+ * Сбрасывает контейнеры предыдущих итераций и счетчики сглаживания.
+ */
+    void LaneDetector::reset() {
+        cont = container(init.cout_containers, init.cout_stripes, static_cast<size_t>(init.parametersBird[9]));
+        cont_poly = container(init.cout_containers, init.cout_stripes, static_cast<size_t>(init.parametersBird[9]));
+        I1.fill(0);
+        I2.fill(999);
+        buffBoolList.fill(true);
+        result_type_of_lines.fill(false);
+        left_right_distance = {0, 0};
+        iteration = 0;
+        frame_number = 0;
+        scene_reference.release();
+        reuse_run = 0;
+        format_reported = false;
+        std::lock_guard<std::mutex> guard(track_lock);
+        tracked.reset(0);
+    }
+
+    const settings& LaneDetector::config() const {
+        return init;
+    }
+
+    stage_profiler& LaneDetector::profiler() {
+        return stages;
+    }
+
+    uint64_t LaneDetector::reused_frames() const {
+        return reused_count.load(std::memory_order_relaxed);
+    }
+
+    void LaneDetector::set_quality(const quality_knobs& knobs) {
+        std::lock_guard<std::mutex> guard(quality_lock);
+        pending_quality = knobs;
+        quality_changed.store(true, std::memory_order_release);
+    }
+
+/**
+ * Применяет параметры качества, заданные set_quality(). Вызывается в начале front_end(): параметры
+ * читает только front_end(), поэтому кадр обрабатывается с одними параметрами от начала до конца.
+ */
+    void LaneDetector::apply_quality() {
+        if (!quality_changed.load(std::memory_order_acquire))
+            return;
+        quality_knobs knobs;
+        {
+            std::lock_guard<std::mutex> guard(quality_lock);
+            knobs = pending_quality;
+            quality_changed.store(false, std::memory_order_relaxed);
+        }
+        init.roi_margin = knobs.roi_margin;
+        init.scan_step = knobs.scan_step;
+        init.scan_budget = knobs.scan_budget;
+        if (std::abs(knobs.pyramid_scale - init.pyramid_scale) > 1e-9) {
+            init.pyramid_scale = knobs.pyramid_scale;
+            if (init.pyramid_scale < 1) {
+                coarse_matrix = pyramid_matrix(matrixBird[0], init.pyramid_scale);
+                if (input != frame_format::bgr)
+                    coarse_chroma_matrix = chroma_matrix(coarse_matrix);
+            }
+        }
+    }
+
+/**
+ * Обрабатывает один кадр: bird преобразование, цветовой фильтр, RANSAC, разделение на полосы,
+ * расчёт полиномов, сглаживание по предыдущим кадрам и расстояния до линий.
+ *
+ * @param frame - кадр с камеры (BGR).
+ * @param result - результат обработки кадра.
+ */
+    void LaneDetector::process(const cv::Mat& frame, Result& result) {
+        trace_scope frame_scope("process");
+        front_end(frame, front);
+        back_end(front, result);
+    }
+
+/**
+ * Первая половина обработки кадра.
+ * При слежении (roi_margin > 0) обрабатываются только полосы вокруг линий последнего обработанного кадра.
+ * В режиме пирамиды (pyramid_scale < 1) линии сначала ищутся в уменьшенном изображении сверху,
+ * а в полном разрешении обрабатываются только полосы вокруг них. Если грубый поиск линий
+ * не нашёл, кадр обрабатывается целиком.
+ * Кадры YUV (input_format nv12, i420) не переводятся в BGR: преобразуются плоскости яркости
+ * и цветности, маска строится по таблице порогов.
+ * В разреженном режиме (sparse_front) кадр в перспективу сверху не переводится, см. sparse_search().
+ * Если сцена не изменилась (static_threshold > 0), кадр не обрабатывается, см. static_scene().
+ * При scan_step > 0 точки для RANSAC - середины отрезков по строкам пятен (scan_line_points()).
+ *
+ * @param frame - кадр с камеры (BGR или YUV 4:2:0 по input_format).
+ * @param data - изображение сверху, маска и отфильтрованные контуры кадра.
+ */
+    void LaneDetector::front_end(const cv::Mat& frame, front_data& data) {
+        apply_quality();
+        data.frame = frame_number++;
+        data.reused = false;
+        data.tracked = false;
+        trace::set_frame(data.frame);
+        trace_scope front_scope("front_end");
+
+        bool yuv = input != frame_format::bgr;
+        if (yuv) {
+            LANE_STAGE_SCOPE(timer, stages, warp);
+            if (!hsv::yuv_planes(frame, input, data.frame_luma, data.frame_chroma)) {
+                // Кадр не того формата: пустая маска, линий нет. Сообщение - один раз на поток кадров.
+                if (!format_reported) {
+                    std::cout << "Ошибка: кадр " << frame.cols << "x" << frame.rows << " не в формате YUV 4:2:0 ("
+                              << init.input_format << "), линии не ищутся" << std::endl;
+                    format_reported = true;
+                }
+                data.bird.create(init.parametersBird[8], init.parametersBird[9], CV_8UC1);
+                data.bird.setTo(cv::Scalar::all(0));
+                data.mask = cv::Mat::zeros(data.bird.size(), CV_8UC1);
+                data.contours.clear();
+                data.coord.clear();
+                return;
+            }
+        }
+
+        if ((init.static_threshold > 0) && static_scene(yuv ? data.frame_luma : frame, data))
+            return;
+
+        if (init.sparse_front != 0) {
+            sparse_search(yuv ? data.frame_luma : frame, data);
+            return;
+        }
+
+        data.tracked = (init.roi_margin > 0) && track_search(data);
+        bool partial = data.tracked || ((init.pyramid_scale < 1) && coarse_search(frame, data));
+        if (!partial)
+            data.bands.clear();
+        if (yuv) {
+            refine_yuv(data);
+        } else if (partial) {
+            refine_bands(frame, data);
+        } else {
+            LANE_STAGE_SCOPE(timer, stages, warp);
+            Bird_view::warpImage(frame, frame, matrixBird, init.parametersBird, data.bird, 'n'); // Приенение матрицы
+
+            LANE_STAGE_NEXT(timer, threshold);
+            hsv::return_hsv(data.bird, init.parametersHSV, data.hls, data.mask); // получение полутонового изображения
+        }
+
+        LANE_STAGE_SCOPE(timer, stages, contours);
+        //фильтрация полученных контуров
+        hsv::filtered_img(data.mask, data.contours, data.coord, data.filter);
+        if (init.scan_step > 0)
+            scan_line_points(data.mask, data.contours, init.scan_step, init.scan_budget, data.scan_labels, data.coord);
+    }
+
+/**
+ * Неизменная сцена (стоянка): сигнатура трапеции сравнивается с сигнатурой последнего обработанного
+ * кадра, а не предыдущего, поэтому медленные изменения накапливаются и не пропускаются.
+ * Повторов подряд не больше static_max_reuse.
+ *
+ * @param frame - кадр BGR или яркость кадра YUV.
+ * @return true, если кадр не обрабатывается и back_end() повторит результат последнего обработанного кадра.
+ */
+    bool LaneDetector::static_scene(const cv::Mat& frame, front_data& data) {
+        LANE_STAGE_SCOPE(timer, stages, change);
+        scene_signature(frame, init.parametersBird, data.signature_small, data.signature);
+        if ((reuse_run < init.static_max_reuse) &&
+            (signature_change(data.signature, scene_reference) < init.static_threshold)) {
+            reuse_run++;
+            data.reused = true;
+            return true;
+        }
+        data.signature.copyTo(scene_reference);
+        reuse_run = 0;
+        return false;
+    }
+
+/**
+ * Разреженный front end: цветовой фильтр в кадре камеры только внутри трапеции parametersBird,
+ * пятна разметки проецируются в изображение сверху матрицей M и фильтруются там.
+ * Время пропорционально площади трапеции и количеству пикселей разметки, а не площади изображения сверху.
+ * Изображение сверху не строится: data.bird - маска проекций пятен.
+ *
+ * @param frame - кадр BGR или яркость кадра YUV.
+ */
+    void LaneDetector::sparse_search(const cv::Mat& frame, front_data& data) {
+        if (data.sparse.spans.empty())
+            sparse_spans(init.parametersBird, data.sparse);
+
+        LANE_STAGE_SCOPE(timer, stages, threshold);
+        sparse_threshold(frame, data.frame_chroma, init.parametersHSV, lut, data.sparse);
+
+        LANE_STAGE_NEXT(timer, contours);
+        sparse_blobs(matrixBird[0], cv::Size(init.parametersBird[9], init.parametersBird[8]), data.sparse,
+                     data.contours, data.coord, data.mask);
+        if (init.scan_step > 0)
+            scan_line_points(data.mask, data.contours, init.scan_step, init.scan_budget, data.scan_labels, data.coord);
+        data.mask.copyTo(data.bird);
+    }
+
+/**
+ * Полосы вокруг сглаженных линий последнего обработанного back_end() кадра. В конвейере это
+ * кадр, отстающий на глубину конвейера, поэтому roi_margin должен покрывать смещение линий за это время.
+ *
+ * @return false, если линии потеряны или кадр нужно обработать целиком для поиска новых линий.
+ */
+    bool LaneDetector::track_search(front_data& data) {
+        if ((init.roi_reacquire_interval > 0) && (data.frame % static_cast<uint64_t>(init.roi_reacquire_interval) == 0))
+            return false;
+        lane_polys previous;
+        {
+            std::lock_guard<std::mutex> guard(track_lock);
+            previous = tracked;
+        }
+        track_bands(previous, init.roi_margin, cv::Size(init.parametersBird[9], init.parametersBird[8]), data.bands);
+        return !data.bands.empty();
+    }
+
+/**
+ * Грубый поиск: bird преобразование в уменьшенное изображение, цветовой фильтр, контуры и RANSAC
+ * с порогами, умноженными на масштаб.
+ *
+ * @return true, если найдена хотя бы одна полоса для уточнения.
+ */
+    bool LaneDetector::coarse_search(const cv::Mat& frame, front_data& data) {
+        double scale = init.pyramid_scale;
+        LANE_STAGE_SCOPE(timer, stages, coarse);
+        cv::Size size(std::max(1, static_cast<int>(std::lround(init.parametersBird[9] * scale))),
+                      std::max(1, static_cast<int>(std::lround(init.parametersBird[8] * scale))));
+        if (input == frame_format::bgr) {
+            cv::warpPerspective(frame, data.coarse_bird, coarse_matrix, size);
+            hsv::return_hsv(data.coarse_bird, init.parametersHSV, data.coarse_hls, data.coarse_mask);
+        } else {
+            const std::vector<cv::Range> whole_image;
+            hsv::warp_yuv(data.frame_luma, data.frame_chroma, coarse_matrix, coarse_chroma_matrix, size, whole_image,
+                          data.coarse_bird, data.coarse_chroma);
+            hsv::threshold_yuv(data.coarse_bird, data.coarse_chroma, lut, whole_image, data.coarse_mask);
+        }
+        hsv::filtered_img(data.coarse_mask, data.coarse_contours, data.coarse_coord, data.coarse_filter, scale);
+
+        size_t min_inliers = std::max<size_t>(2, static_cast<size_t>(static_cast<double>(init.min_inliers) * scale));
+        RANSACLines(data.coarse_coord, min_inliers, std::max(1.0, init.Dist_threshold * scale), data.coarse_lines);
+        rm_slanted_lines(data.coarse_lines);
+        pyramid_bands(data.coarse_lines, scale, init.pyramid_margin,
+                      cv::Size(init.parametersBird[9], init.parametersBird[8]), data.bands);
+        return !data.bands.empty();
+    }
+
+/**
+ * Уточнение в полном разрешении: bird преобразование и цветовой фильтр только в полосах
+ * вокруг грубых или отслеживаемых линий. Остальная часть изображения сверху и маски обнуляется.
+ */
+    void LaneDetector::refine_bands(const cv::Mat& frame, front_data& data) {
+        cv::Size size(init.parametersBird[9], init.parametersBird[8]);
+
+        LANE_STAGE_SCOPE(timer, stages, warp);
+        data.bird.create(size, frame.type());
+        data.bird.setTo(cv::Scalar::all(0));
+        for (auto &band : data.bands)
+            warp_band(frame, matrixBird[0], band, data.bird);
+
+        LANE_STAGE_NEXT(timer, threshold);
+        data.hls.create(size, frame.type());
+        data.mask.create(size, CV_8UC1);
+        data.mask.setTo(cv::Scalar::all(0));
+        for (auto &band : data.bands) {
+            // Заголовки столбцов: результат пишется в память полных изображений.
+            cv::Mat hls_band = data.hls.colRange(band.start, band.end);
+            cv::Mat mask_band = data.mask.colRange(band.start, band.end);
+            hsv::return_hsv(data.bird.colRange(band.start, band.end), init.parametersHSV, hls_band, mask_band);
+        }
+    }
+
+/**
+ * Bird преобразование и пороги кадра YUV: целиком или только в полосах data.bands.
+ */
+    void LaneDetector::refine_yuv(front_data& data) {
+        cv::Size size(init.parametersBird[9], init.parametersBird[8]);
+
+        LANE_STAGE_SCOPE(timer, stages, warp);
+        hsv::warp_yuv(data.frame_luma, data.frame_chroma, matrixBird[0], bird_chroma_matrix, size, data.bands,
+                      data.bird, data.chroma);
+
+        LANE_STAGE_NEXT(timer, threshold);
+        hsv::threshold_yuv(data.bird, data.chroma, lut, data.bands, data.mask);
+    }
+
+/**
+ * Вторая половина обработки кадра. Использует и обновляет данные предыдущих кадров.
+ * Для кадра неизменной сцены повторяется результат последнего обработанного кадра.
+ *
+ * @param data - результат front_end() для этого кадра.
+ * @param result - результат обработки кадра.
+ */
+    void LaneDetector::back_end(front_data& data, Result& result) {
+        result.frame = data.frame;
+        trace::set_frame(result.frame);
+        trace_scope back_scope("back_end");
+        if (data.reused) {
+            // Сцена не изменилась: состояние сглаживания не меняется, повторяется последний результат.
+            copy_values(last_result, result);
+            last_result.bird.copyTo(result.bird);
+            result.reused = true;
+            result.tracked = false;
+            result.points = 0;
+            reused_count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        result.reused = false;
+        result.tracked = data.tracked;
+        result.points = data.coord.size();
+
+        if (iteration < 20) {
+            iteration++;
+        } // общий итератор цикла
+
+        // Буферы меняются местами, память обоих изображений переиспользуется.
+        std::swap(result.bird, data.bird);
+
+        // Применение RANSAC для обнаружения линий.
+        LANE_STAGE_SCOPE(timer, stages, ransac);
+        RANSACLines(data.coord, init.min_inliers, init.Dist_threshold, lines);
+
+        // Удаление наклонных линий.
+        LANE_STAGE_NEXT(timer, stripes);
+        rm_slanted_lines(lines);
+        //Разделить изображение на полосы и выделить в каждой из них свою линию разметки
+        division_into_stripes(lines, cont, vec_container_stripes, stripes);
+
+        // Поиск координат для нахождения полиномов.
+        LANE_STAGE_NEXT(timer, association);
+        find_x_y(stripes, data.contours, init.width_line_search, coord_for_lines);
+
+        //Расчёт полиномов из полученных ранее координат
+        LANE_STAGE_NEXT(timer, polyfit);
+        x_y_to_polynom(coord_for_lines, result.lines);
+
+        // Штрихи и разрывы вдоль каждой линии по маске кадра.
+        LANE_STAGE_NEXT(timer, dashes);
+        for (size_t i = 0; i < result.lines.size(); i++) {
+            mask_profile(data.mask, result.lines[i], std::max(1, init.width_line_search / 4), result.dashes[i]);
+            result.lines.duty[i] = static_cast<float>(result.dashes[i].duty());
+        }
+
+        // Добавление результатов в контейнер и нормализация данных.
+        LANE_STAGE_NEXT(timer, smoothing);
+        container::add_to_container(result.lines, cont_poly.contain);
+        if (iteration > 10)
+            container::normalizeData(cont_poly.contain, I1, buffBoolList, I2, init.sense_to_normolize_data);
+        result.smoothed = cont_poly.contain.back();
+        // Тип линий - по заполненности, усреднённой по контейнеру.
+        return_type_of_line(cont_poly.contain, init.solid_duty, result_type_of_lines);
+        result.types = result_type_of_lines;
+
+        //Получение дистанции до левой и правой полосы
+        LANE_STAGE_NEXT(timer, distance);
+        get_three_point_vector(result.lines, result.bird.size(), matrixBird[1], init.transformationMatrix,
+                               left_right_distance, result.three_points);
+        result.left_right_distance = left_right_distance;
+        result.lines_detected = lines_found(result.lines);
+
+        // Публикуется всегда: слежение может включить регулятор качества (roi_margin читает только front_end()).
+        {
+            std::lock_guard<std::mutex> guard(track_lock);
+            tracked = result.lines_detected ? result.smoothed : lane_polys{};
+        }
+        if (init.static_threshold > 0) {
+            // Изображение сверху не копируется: заголовок ссылается на буфер result.bird. Этот буфер попадает
+            // в front_data только при обмене в следующем back_end(), после которого заголовок заменяется.
+            copy_values(result, last_result);
+            last_result.bird = result.bird;
+        }
+    }
+
+/**
+ * Рисует линии в перспективе сверху, переводит их в перспективу камеры и накладывает на кадр
+ * вместе с расстояниями до левой и правой линии.
+ *
+ * @param frame - исходный кадр BGR (кадр YUV переводится в BGR вызывающей стороной).
+ * @param result - результат process() для этого кадра.
+ * @param out - изображение для отображения.
+ */
+    void LaneDetector::render(const cv::Mat& frame, const Result& result, cv::Mat& out) {
+        LANE_STAGE_SCOPE(timer, stages, render);
+        line_image.create(result.bird.size(), CV_8UC3);
+        line_image.setTo(cv::Scalar::all(0));
+        draw_lines(line_image, result.lines, result.types);
+
+        // Рисуем точку в центре изображения
+        cv::circle(line_image, {line_image.cols / 2, line_image.rows}, 20, cv::Scalar(0, 0, 255), 10);
+
+        //Применение матрицы преобразования в обратном режиме
+        Bird_view::warpImage(line_image, frame, matrixBird, init.parametersBird, line_warped, 'r');
+        cv::add(line_warped, frame, out);
+
+        // Отображение информации о расстоянии.
+        cv::Scalar textColor = {0, 0, 0};
+        cv::Point textPosition = {400, 100};
+        std::stringstream ss1;
+        ss1 << std::fixed << std::setprecision(2) << result.left_right_distance[0];
+        putText(out, "left " + ss1.str() + " m", textPosition, cv::FONT_HERSHEY_SIMPLEX, init.fontSize, textColor, init.thickness);
+
+        std::stringstream ss2;
+        textPosition.y += 50;
+        ss2 << std::fixed << std::setprecision(2) << result.left_right_distance[1];
+        putText(out, "right " + ss2.str() + " m", textPosition, cv::FONT_HERSHEY_SIMPLEX, init.fontSize, textColor, init.thickness);
+    }
+
+}
@@ -12,51 +12,45 @@ namespace RansacNamespace {
  * @param vector_stripes_widh Вектор, содержащий диапазоны ширин полос,
  * где каждый элемент представляет собой интервал [min, max], где min - минимальная ширина,
  * а max - максимальная ширина полосы.
+ * @param stripes Линии по полосам (нулевая линия - в полосе линии нет).
  */
-    void division_into_stripes(TL &lines, container &cont, std::vector<cv::Point2d>& vector_stripes_widh) {
-        TL good_lines; // Создаем вектор для хранения линий, относящихся к полосам.
-        good_lines.clear();
-        good_lines.resize(cont.quantity_stripes);
+    void division_into_stripes(const std::vector<LanePoly> &lines, container &cont, std::vector<cv::Point2d>& vector_stripes_widh,
+                               lane_polys& stripes) {
+        // Самый старый элемент контейнера переиспользуется для линий текущего кадра.
+        std::rotate(cont.contain.begin(), cont.contain.begin() + 1, cont.contain.end());
+        lane_polys &good_lines = cont.contain.back(); // Линии, относящиеся к полосам.
+        good_lines.reset(cont.quantity_stripes);
         double min, max;
 
         // Проходим по каждой полосе и выбираем линии, которые находятся в данной полосе.
-        for (size_t i = 0; i < vector_stripes_widh.size(); i++) {
+        for (size_t i = 0; (i < vector_stripes_widh.size()) && (i < good_lines.size()); i++) {
             min = vector_stripes_widh[i].x;
             max = vector_stripes_widh[i].y;
             for (auto& line : lines) {
-                double x_sample = -line.coefs[2] / line.coefs[1]; // Вычисляем x-координату пересечения с осью Y.
+                double x_sample = line.c; // x-координата пересечения с осью Y.
                 if ((x_sample > min) && (x_sample < max)) {
                     good_lines[i] = line;
                 }
             }
         }
 
-        // Добавляем линии в контейнер и обновляем вектор линий.
-        cont.add_to_container(good_lines, cont.contain);
-        lines.clear();
-        lines = good_lines;
+        stripes = good_lines;
     }
 
 
 /**
  * Удаляет наклонные линии из заданного вектора линий.
  *
- * @param lines     Вектор линий, из которого нужно удалить наклонные линии.
- * @return          Вектор линий без наклонных линий.
+ * @param lines     Вектор линий, из которого нужно удалить наклонные линии (на их месте остаются нулевые линии).
  */
-    void rm_slanted_lines(TL &lines) {
-        TL good_lines; // Создаем вектор для хранения "хороших" (не наклонных) линий.
-        good_lines.resize(lines.size());
-
+    void rm_slanted_lines(std::vector<LanePoly> &lines) {
         // Проходим по каждой линии и проверяем угол наклона, удаляем линии с большим углом наклона.
-        for (size_t i = 0; i < lines.size(); i++) {
-            double tangle = -(lines[i].coefs[1]) / lines[i].coefs[0]; // Вычисляем угол наклона.
-            if (abs(tangle) > 7) { // Пороговое значение для угла наклона.
-                good_lines[i] = lines[i]; // Добавляем "хорошую" линию в результат.
+        for (auto &line : lines) {
+            // Котангенс угла наклона к горизонтали равен 1/b: |1/b| > 7 проверяется без деления (b = 0 - вертикальная линия).
+            if (!(std::abs(line.b) * 7 < 1)) { // Пороговое значение для угла наклона.
+                line = LanePoly{0, 0, 0};
             }
         }
-        lines.clear();
-        lines = good_lines;
     }
 
 
@@ -66,23 +60,20 @@ namespace RansacNamespace {
  * @param lines Вектор прямых линий для анализа.
  * @return bool Возвращает true, если обнаружены линии, иначе - false.
  */
-    bool lines_found(TL& lines) {
+    bool lines_found(const lane_polys& lines) {
         bool no_lines_detected = true; // Переменная для отслеживания отсутствия обнаруженных линий
         size_t count_of_line = 0; // Счетчик обнаруженных линий
 
         // Перебор каждой линии в векторе lines
-        for (auto l : lines) {
-            // Проверка коэффициента l.coefs[2] на положительное значение
-            if ((l.coefs[2] > 0) || (l.coefs[2] < 0))
+        for (auto &l : lines) {
+            // Проверка коэффициента l.c на ненулевое значение
+            if ((l.c > 0) || (l.c < 0))
                 count_of_line++; // Увеличение счетчика обнаруженных линий
         }
 
         // Проверка количества обнаруженных линий
         if (count_of_line == 0) {
-            no_lines_detected = false; // Обнаружены линии
-            std::cout << "Линий не обнаружено";
-        } else {
-            std::cout << "Линии обнаружены";
+            no_lines_detected = false; // Линии не обнаружены
         }
 
         return no_lines_detected; // Возвращается результат: true - если линии не обнаружены, иначе - false
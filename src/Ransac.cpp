@@ -13,33 +13,32 @@ using namespace std;
 /**
  * RANSACLines - функция для обнаружения линий в наборе точек методом RANSAC.
  *
- * @param coords - входной вектор точек, на которых будет выполняться поиск линий.
+ * @param coords - входные точки (строки и столбцы), на которых будет выполняться поиск линий.
  * @param min_inliers - минимальное количество точек, необходимое для определения линии (по умолчанию: 200).
  * @param DIST_THRESHOLD - пороговое расстояние для RANSAC (по умолчанию: 0.3).
- * @return Вектор обнаруженных линий типа TLine2D.
+ * @param lines - вектор обнаруженных прямых в виде LanePoly (col = b*row + c, a = 0).
+ *
+ * RANSAC MRPT берёт выборки из общего для процесса генератора mrpt::random::getRandomGenerator()
+ * без синхронизации, поэтому вызовы из разных детекторов (части process_offline, грубый поиск
+ * и back_end конвейера) выполняются по одному под ransac_mutex.
  */
-RansacNamespace::TL RansacNamespace::RANSACLines(std::vector<cv::Point>& coords, size_t min_inliers, double DIST_THRESHOLD) {
-    RansacNamespace::CVD x;
-    RansacNamespace::CVD y;
-
-    // Преобразуем координаты точек из формата (x, y) в (y, x).
-    for (auto &xy: coords) {
-        x.push_back(xy.y);
-        y.push_back(xy.x);
-    }
+static std::mutex ransac_mutex;
 
-    std::vector<TLine2D> lines; // Вектор для хранения обнаруженных линий.
+void RansacNamespace::RANSACLines(const point_buffer& coords, size_t min_inliers, double DIST_THRESHOLD, std::vector<LanePoly>& lines) {
     vector<pair<size_t, TLine2D>> detectedLines; // Вектор пар, где первый элемент - количество точек, второй - линия.
 
-    // Вызываем функцию ransac_detect_2D_lines для обнаружения линий.
-    ransac_detect_2D_lines(x, y, detectedLines, DIST_THRESHOLD, min_inliers);
+    // Строки точек передаются как x, столбцы - как y: линия получается в координатах (строка, столбец).
+    {
+        std::lock_guard<std::mutex> lock(ransac_mutex);
+        ransac_detect_2D_lines(coords.rows, coords.cols, detectedLines, DIST_THRESHOLD, min_inliers);
+    }
 
-    // Переносим обнаруженные линии в вектор lines.
+    // Линия A*row + B*col + C = 0 переводится в вид col = b*row + c.
+    lines.clear();
     for (auto p = detectedLines.begin(); p != detectedLines.end(); p++ ){
-        lines.push_back(p->second);
+        const double *k = p->second.coefs;
+        if (std::abs(k[1]) < 1e-12)
+            continue; // Горизонтальная линия (постоянная строка) - не разметка.
+        lines.push_back({0, static_cast<float>(-k[0] / k[1]), static_cast<float>(-k[2] / k[1])});
     }
-
-    return lines;
 }
-
-
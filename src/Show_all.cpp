@@ -11,9 +11,9 @@ namespace RansacNamespace {
  */
     void cout_line(container &cont, size_t len) {
         std::cout << "\n\nУравнения линий:\n";
-        for (mrpt::math::TLine2D line : cont.contain[len]) {
+        for (const LanePoly &line : cont.contain[len]) {
             // Выводим коэффициенты уравнения линии в формате [a, b, c].
-            std::cout << "\n [" << line.coefs[0] << ", " << line.coefs[1] << ", " << line.coefs[2] << " ]";
+            std::cout << "\n [" << line.a << ", " << line.b << ", " << line.c << " ]";
         }
     }
 
@@ -22,16 +22,16 @@ namespace RansacNamespace {
  *
  * @param cont      Контейнер, содержащий линии, которые нужно отобразить на карте дороги.
  * @param len       Индекс, указывающий на сегмент линий в контейнере, который нужно отобразить.
- * @param types      Указатель на вектор с типами линий.
+ * @param types      Типы линий по полосам.
  */
-    void show_road_map(container &cont, size_t len, std::vector<bool>& types) {
+    void show_road_map(container &cont, size_t len, const stripe_flags& types) {
 
         std::cout << "\n\nКарта дороги:                             \n..";
         std::string output;
         for (size_t i = 0; i<cont.contain[len].size(); i++) {
-            mrpt::math::TLine2D line = cont.contain[len][i];
+            const LanePoly &line = cont.contain[len][i];
             bool type = types[i];
-            if (line.coefs[2] <= 0) {
+            if (line.c <= 0) {
                 // Если линия не обнаружена (коэффициент c <= 0), выводим символ " ".
                 output += "   .";
             } else {
@@ -25,28 +25,29 @@ namespace RansacNamespace {
  * @param lines         Вектор линий для добавления в контейнер.
  * @param cont          Вектор контейнеров для хранения линий.
  */
-    void container::add_to_container(TL lines, std::vector<TL> &cont) {
-        cont.erase(cont.begin()); // Удаляем старый контейнер.
-        cont.push_back(lines); // Добавляем новый вектор линий в контейнер.
+    void container::add_to_container(const lane_polys& lines, std::vector<lane_polys> &cont) {
+        // Старые линии перемещаются в конец и перезаписываются новыми.
+        std::rotate(cont.begin(), cont.begin() + 1, cont.end());
+        cont.back() = lines;
     }
 
 /**
- * Функция `check_boolean_list` проверяет и обновляет булевый список на основе изменений и счетчика.
+ * Функция `check_boolean_list` проверяет и обновляет булевое значение на основе изменений и счетчика.
  *
- * @param booleanList Вектор булевых значений, который требуется проверить и обновить.
+ * @param found Булевое значение (найдена ли линия), которое требуется проверить и обновить.
  * @param buffBoolList Буферный вектор булевых значений для сравнения с основным.
  * @param I Вектор счетчиков изменений для каждого элемента в булевом списке.
  * @param sense Порог изменений, после которого булевое значение считается измененным.
  * @param i Индекс элемента, который нужно проверить и обновить в списках.
  */
-    void container::check_boolean_list(std::vector<bool> &booleanList, std::vector<bool> &buffBoolList, std::vector<int> &I, int sense, size_t i) {
-        if (buffBoolList[i] != booleanList[i]) { // Проверяем, изменилось ли текущее булевое значение.
+    void container::check_boolean_list(bool &found, stripe_flags &buffBoolList, stripe_counters &I, int sense, size_t i) {
+        if (buffBoolList[i] != found) { // Проверяем, изменилось ли текущее булевое значение.
             if (I[i] <= sense) {
-                booleanList[i] = buffBoolList[i]; // Обновляем булевое значение.
+                found = buffBoolList[i]; // Обновляем булевое значение.
                 I[i]++; // Увеличиваем счетчик изменений.
             } else {
                 I[i] = 0; // Сбрасываем счетчик изменений.
-                buffBoolList[i] = booleanList[i]; // Обновляем буферное булевое значение.
+                buffBoolList[i] = found; // Обновляем буферное булевое значение.
             }
         } else {
             I[i] = 0; // Сбрасываем счетчик изменений, если булевое значение не изменилось.
@@ -61,32 +62,35 @@ namespace RansacNamespace {
  * @param container Вектор линий, в котором выполняется удаление "пустых" линий.
  * @param I1 Вектор счетчиков изменений для каждой линии в контейнере.
  * @param I2 Вектор счетчиков для "пустых" линий.
- * @param booleanList Вектор булевых значений, определяющих изменения в линиях.
  * @param buffBoolList Буферный вектор булевых значений для сравнения с основным.
  * @param len Индекс текущего контейнера (списка линий).
  * @param sense Порог изменений, после которого булевое значение считается измененным.
  */
-    void container::delete_space(std::vector<TL> &container,
-                                 std::vector<int> &I1, std::vector<int> &I2,
-                                 std::vector<bool> &booleanList, std::vector<bool> &buffBoolList,
+    void container::delete_space(std::vector<lane_polys> &container,
+                                 stripe_counters &I1, stripe_counters &I2,
+                                 stripe_flags &buffBoolList,
                                  size_t len, int sense) {
         for (size_t i = 0; i < container[len].size(); i++) {
+            // Наличие линии определяется до изменения элемента i.
+            bool found = static_cast<int>(container[len][i].c) != 0;
             // Проверяем, является ли текущая линия "пустой" (без значимых коэффициентов).
-            if (int(container[len][i].coefs[2]) == 0) {
+            if (int(container[len][i].c) == 0) {
                 I2[i]++;
                 if (I2[i] < sense) {
                     size_t k = 1;
                     container[len][i] = container[len - k][i]; // Заменяем текущую линию на предыдущую.
+                    container[len].duty[i] = container[len - k].duty[i]; // Вместе с заполненностью разметкой.
                 } else {
                     I2[i] = 0; // Сбрасываем счетчик изменений для "пустой" линии.
                 }
             }
-            check_boolean_list(booleanList, buffBoolList, I1, sense, i); // Проверяем и обновляем булевый список.
+            check_boolean_list(found, buffBoolList, I1, sense, i); // Проверяем и обновляем булевое значение.
 
-            if (int(container[len][i].coefs[2]) == 0) {
-                if (booleanList[i]) {
+            if (int(container[len][i].c) == 0) {
+                if (found) {
                     size_t k = 1;
                     container[len][i] = container[len - k][i]; // Заменяем текущую линию на предыдущую.
+                    container[len].duty[i] = container[len - k].duty[i]; // Вместе с заполненностью разметкой.
                 } else {
                     container[len][i] = {0, 0, 0}; // Если булевое значение ложное, устанавливаем линию как пустую.
                 }
@@ -104,19 +108,13 @@ namespace RansacNamespace {
  * @param I2            Вектор счетчиков для каждой линии в списке.
  * @param sense         Пороговое значение для нормализации данных.
  */
-    void container::normalizeData(std::vector<TL> &container,
-                                  std::vector<int> &I1, std::vector<bool> &buffBoolList, std::vector<int> &I2,
+    void container::normalizeData(std::vector<lane_polys> &container,
+                                  stripe_counters &I1, stripe_flags &buffBoolList, stripe_counters &I2,
                                   int sense) {
-        std::vector<bool> booleanList; // Создаем вектор булевых значений для каждой линии.
         size_t len = container.size() - 1; // Получаем индекс текущего контейнера линий.
 
-        // Заполняем вектор booleanList значениями, указывающими на наличие линий в текущем контейнере.
-        for (mrpt::math::TLine2D line : container[len]) {
-            booleanList.push_back(static_cast<int>(line.coefs[2]) != 0);
-        }
-
         // Вызываем функцию delete_space для удаления лишних данных в текущем контейнере линий.
-        delete_space(container, I1, I2, booleanList, buffBoolList, len, sense);
+        delete_space(container, I1, I2, buffBoolList, len, sense);
     }
 
 
@@ -3,23 +3,88 @@
 namespace RansacNamespace{
 
 /**
- * return_type_of_line - функция для определения типа линий на основе количества контуров в них.
+ * mask_profile - штрихи и разрывы разметки вдоль линии.
+ * Линия проходится по строкам маски (столбец считается так же, как в param_to_coord()), в каждой строке
+ * разметка ищется в окне +-half_width вокруг линии. Подряд идущие строки с разметкой - штрих, без неё - разрыв.
+ * Сложность - O(строк изображения) на линию.
  *
- * @param count_contours_in_line - вектор, содержащий количество контуров в каждой линии.
- * @param result_type_of_lines - вектор, в который будет записан результат определения типа линий.
- *                              Если линия содержит более одного контура, тип будет "false", иначе "true".
+ * @param mask - бинарная маска изображения сверху (CV_8UC1).
+ * @param line - линия.
+ * @param half_width - половина ширины окна поиска, пиксели.
+ * @param profile - результат (нулевой, если линия не найдена).
  */
-    void return_type_of_line(std::vector<int>& count_contours_in_line, std::vector<bool>& result_type_of_lines) {
-        result_type_of_lines.clear(); // Очищаем вектор результатов.
+    void mask_profile(const cv::Mat& mask, const LanePoly& line, int half_width, dash_profile& profile) {
+        profile = dash_profile{};
+        if (!line.found() || mask.empty())
+            return;
 
-        for (size_t i = 0; i < count_contours_in_line.size(); i++) {
-            if (count_contours_in_line[i] > 1) {
-                result_type_of_lines.push_back(false); // Линия содержит более одного контура, тип "false".
+        int run = 0;
+        bool run_on = false;
+        // Завершает текущую последовательность строк.
+        auto close_run = [&]() {
+            if (run == 0)
+                return;
+            if (run_on) {
+                profile.dashes++;
+                profile.longest_dash = std::max(profile.longest_dash, run);
             } else {
-                result_type_of_lines.push_back(true); // Линия содержит один контур, тип "true".
+                profile.gaps++;
+                profile.longest_gap = std::max(profile.longest_gap, run);
             }
+            run = 0;
+        };
+
+        for (int row = 0; row < mask.rows; row++) {
+            double x = line.x(row);
+            if ((x < 0) || (x >= mask.cols)) {
+                close_run(); // Линия вне изображения: строка не учитывается.
+                continue;
+            }
+            int col = static_cast<int>(x);
+            int from = std::max(0, col - half_width);
+            int to = std::min(mask.cols - 1, col + half_width);
+            const uint8_t *p = mask.ptr<uint8_t>(row);
+            bool on = false;
+            for (int c = from; (c <= to) && !on; c++)
+                on = p[c] != 0;
+
+            profile.rows++;
+            if (on)
+                profile.on_rows++;
+            if ((run > 0) && (on != run_on))
+                close_run();
+            run_on = on;
+            run++;
+        }
+        close_run();
+    }
+
+/**
+ * return_type_of_line - функция для определения типа линий по доле строк с разметкой вдоль линии.
+ * Доля усредняется по кадрам контейнера, в которых линия найдена, поэтому тип не мигает
+ * при пропуске штриха в одном кадре.
+ *
+ * @param history - контейнер линий предыдущих кадров (последний элемент - текущий кадр).
+ * @param solid_duty - минимальная доля строк с разметкой для сплошной линии.
+ * @param result_type_of_lines - результат: true - сплошная, false - прерывистая или линия не найдена.
+ */
+    void return_type_of_line(const std::vector<lane_polys>& history, double solid_duty, stripe_flags& result_type_of_lines) {
+        result_type_of_lines.fill(false); // Очищаем результаты.
+        if (history.empty())
+            return;
+
+        for (size_t i = 0; i < history.back().size(); i++) {
+            double sum = 0;
+            size_t n = 0;
+            for (const lane_polys &lines : history) {
+                if ((i < lines.size()) && lines[i].found()) {
+                    sum += lines.duty[i];
+                    n++;
+                }
+            }
+            result_type_of_lines[i] = (n > 0) && (sum >= solid_duty * static_cast<double>(n));
         }
     }
 
 
-}
\ No newline at end of file
+}
@@ -1,20 +1,22 @@
 #include "../include/Ransac.h"
 
+#include <cfloat>
+
 namespace RansacNamespace{
 
 
 /**
  * Возвращает координаты точки на нижней части линии в заданной строке `y`.
  *
- * @param line Линия (в виде mrpt::math::TLine2D), для которой нужно определить координаты точки.
+ * @param line Линия, для которой нужно определить координаты точки.
  * @param y Координата `y`, на основе которой будет определена координата `x`.
  * @return cv::Point Точка с координатами x и y на линии.
  */
-    cv::Point return_xy_low_point(mrpt::math::TLine2D &line, int y) {
+    cv::Point return_xy_low_point(const LanePoly &line, int y) {
         cv::Point minmax;
         minmax.y = y;
         // Расчет координаты x для заданной строки y на основе уравнения линии.
-        minmax.x = static_cast<int>(line.coefs[0]*y*y + line.coefs[1]*y + line.coefs[2]);
+        minmax.x = static_cast<int>(line.x(y));
         return minmax;
     }
 
@@ -25,10 +27,10 @@ namespace RansacNamespace{
  * @param x1 Первая координата x.
  * @param x2 Вторая координата x.
  * @param x3 Третья координата x.
- * @param line Линия (в виде mrpt::math::TLine2D), для которой нужно определить три точки.
+ * @param line Линия, для которой нужно определить три точки.
  * @return std::vector<cv::Point> Вектор, содержащий три точки на линии.
  */
-    std::vector<cv::Point> three_dots_l_r(int x1, int x2, int x3, mrpt::math::TLine2D &line) {
+    std::vector<cv::Point> three_dots_l_r(int x1, int x2, int x3, const LanePoly &line) {
         std::vector<cv::Point> points;
         // Получаем три точки на линии, соответствующие заданным координатам x1, x2, x3.
         points.push_back(return_xy_low_point(line, x1));
@@ -43,15 +45,12 @@ namespace RansacNamespace{
  * \brief Возвращает три вектора точек в координатах изображения после преобразования перспективы.
  *
  * Функция принимает вектор векторов точек `points` и выполняет преобразование перспективы для этих точек.
- * Используются параметры `parametersBird` из настроек (`init.parametersBird`) для выполнения преобразования.
+ * Преобразованные точки группируются по три: первые три - в points[0], следующие три - в points[1].
  *
  * \param points Вектор векторов точек для преобразования.
+ * \param Minv Обратная матрица bird преобразования (из return_bird_matrix()).
  */
-    void return_three_vec_point_in_img_coord(std::vector<std::vector<cv::Point>>& points) {
-        // Инициализация настроек
-        settings init;
-        // Получение параметров для преобразования
-        auto parameters = init.parametersBird;
+    void return_three_vec_point_in_img_coord(std::vector<std::vector<cv::Point>>& points, const cv::Mat& Minv) {
         // Создание векторов для исходных и преобразованных точек
         std::vector<cv::Point2f> srcPoints;
         std::vector<cv::Point2f> dstPoints;
@@ -61,31 +60,16 @@ namespace RansacNamespace{
                 srcPoints.emplace_back(point);
             }
         }
-        // Определение исходных и конечных точек для преобразования перспективы
-        cv::Point2f dst[4] = {cv::Point2i(parameters[0], parameters[1]),
-                              cv::Point2i(parameters[2], parameters[3]),
-                              cv::Point2i(parameters[4], parameters[5]),
-                              cv::Point2i(parameters[6], parameters[7])};
-        cv::Point2f src[4] = {cv::Point2i(0, 0),
-                              cv::Point2i(parameters[9], 0),
-                              cv::Point2i(0, parameters[8]),
-                              cv::Point2i(parameters[9], parameters[8])};
-
-        // Получение матрицы преобразования перспективы
-        cv::Mat M = cv::getPerspectiveTransform(src, dst);
+
         // Преобразование точек
-        cv::perspectiveTransform(srcPoints, dstPoints, M);
+        cv::perspectiveTransform(srcPoints, dstPoints, Minv);
         // Группировка преобразованных точек обратно в вектор std::vector<std::vector<cv::Point>>
         std::vector<std::vector<cv::Point>> transformedPoints(points.size());
         points.clear();
 
-        // Распределение преобразованных точек по векторам
-        transformedPoints[0].push_back(dstPoints[0]);
-        transformedPoints[0].push_back(dstPoints[1]);
-        transformedPoints[0].push_back(dstPoints[2]);
-        transformedPoints[1].push_back(dstPoints[3]);
-        transformedPoints[1].push_back(dstPoints[4]);
-        transformedPoints[1].push_back(dstPoints[5]);
+        // Распределение преобразованных точек по векторам (по три точки)
+        for (size_t i = 0; (i < dstPoints.size()) && (i / 3 < transformedPoints.size()); i++)
+            transformedPoints[i / 3].push_back(dstPoints[i]);
 
         points = transformedPoints; // Присваивание преобразованных точек исходному вектору
     }
@@ -100,19 +84,17 @@ namespace RansacNamespace{
  *
  * \param Center Центр в исходной системе координат типа cv::Point2d.
  * \param point Точка для вычисления расстояния типа cv::Point.
+ * \param transformationMatrix Матрица преобразования в мировые координаты.
  * \return Расстояние до центра в новой системе координат типа cv::Point2d.
  */
-    cv::Point2d find_distance_point_to_center(cv::Point2d Center, cv::Point point) {
-        // Инициализация настроек
-        settings init;
-
+    cv::Point2d find_distance_point_to_center(cv::Point2d Center, cv::Point point, const Eigen::Matrix3d& transformationMatrix) {
         // Создание векторов для точки и центра
         Eigen::Vector3d WC;
         Eigen::Vector3d point_eigen;
         // Задание координат точки в виде вектора Eigen
         point_eigen << point.x, point.y, 1.0;
         // Преобразование координат точки в новую систему с помощью матрицы преобразования
-        point_eigen = init.transformationMatrix * point_eigen;
+        point_eigen = transformationMatrix * point_eigen;
         // Задание координат центра в виде вектора Eigen
         WC << Center.x, Center.y, 1.0;
 
@@ -126,75 +108,80 @@ namespace RansacNamespace{
     }
 
 
+/**
+ * Переводит точку изображения сверху в координаты кадра.
+ * Результат совпадает с cv::perspectiveTransform для Point2f с округлением до пикселя, но без выделения памяти.
+ *
+ * @param point Точка на изображении сверху.
+ * @param Minv Обратная матрица bird преобразования (CV_64F, 3x3).
+ * @return Точка на исходном кадре.
+ */
+    cv::Point point_to_img_coord(cv::Point point, const cv::Mat& Minv) {
+        const double *m = Minv.ptr<double>();
+        double x = static_cast<float>(point.x), y = static_cast<float>(point.y);
+        double w = x * m[6] + y * m[7] + m[8];
+        if (std::abs(w) <= FLT_EPSILON)
+            return {0, 0};
+        w = 1. / w;
+        return cv::Point2f(static_cast<float>((x * m[0] + y * m[1] + m[2]) * w),
+                           static_cast<float>((x * m[3] + y * m[4] + m[5]) * w));
+    }
+
+
 /**
  * Расчитывает крайние левую и правую точки  преобразует точки из координат камеры в мировые
  *
  * @param lines Вектор прямых линий, определяющих контуры дороги.
- * @param image Исходное изображение, на котором будет нарисовано пространство дороги.
+ * @param image_size Размер изображения в перспективе сверху.
+ * @param Minv Обратная матрица bird преобразования.
  * @param transformationMatrix Матрица преобразования для перехода в мировые координаты.
  * @param left_right_distance Вектор расстояний до левой и правой границ дороги.
- * @param Three_points_to_line Вектор векторов точек для каждой из линий.
+ * @param three_points Расстояния от центра до трёх точек левой и правой линии (2 вектора по 3 точки).
  */
-    std::vector<std::vector<cv::Point2d>> get_three_point_vector(TL lines, const cv::Mat &image, Eigen::Matrix3d& transformationMatrix, std::vector<double>& left_right_distance) {
+    void get_three_point_vector(const lane_polys& lines, cv::Size image_size, const cv::Mat& Minv, const Eigen::Matrix3d& transformationMatrix,
+                                std::vector<double>& left_right_distance, std::vector<std::vector<cv::Point2d>>& three_points) {
+        // Без линий расстояния и точки не меняются.
+        if (lines.empty())
+            return;
 
         // Объявление переменных для хранения расстояний и координат
         double left_distance, right_distance;
-        int img_h = image.rows;
-        left_distance = left_right_distance[0];  // Левое расстояние до границы дороги
-        right_distance = left_right_distance[1]; // Правое расстояние до границы дороги
+        int img_h = image_size.height;
         size_t r_i, l_i;  // Индексы левой и правой линий дороги
         Eigen::Vector3d worldCoordinates1, worldCoordinates2, worldCenter;  // Мировые координаты точек
-        std::vector<std::vector<cv::Point>> minmax_vector;  // Вектор для хранения точек
         Eigen::Vector3d Point_on_image_left, Point_on_image_right;  // Точки на изображении
-        int Center_img = static_cast<int>(floor(image.cols / 2)); // Координата центра изображения по горизонтали
-        std::vector<std::vector<cv::Point>> buf;
-        std::vector<std::vector<cv::Point>> Three_points_to_line;
-        std::vector<std::vector<cv::Point2d>> retThree_points_to_line;
-
-        // Проверка наличия линий
-        if (!lines.empty()) {
-            r_i = 0;
-            // Находим точку на нижней части линии слева от центра изображения
-            cv::Point xy2 = return_xy_low_point(lines[r_i], img_h);
-            while (((xy2.x < Center_img)) && (r_i < lines.size())) {
-                r_i++;
-                xy2 = return_xy_low_point(lines[r_i], img_h);
-            }
-
-            // Обработка выхода за границы вектора линий
-            if (r_i > lines.size()-1){
-                r_i--;
-                xy2 = return_xy_low_point(lines[r_i], img_h);
-            }
+        int Center_img = static_cast<int>(floor(image_size.width / 2)); // Координата центра изображения по горизонтали
+
+        r_i = 0;
+        // Находим точку на нижней части линии слева от центра изображения
+        cv::Point xy2 = return_xy_low_point(lines[r_i], img_h);
+        while (((xy2.x < Center_img)) && (r_i + 1 < lines.size())) {
+            r_i++;
+            xy2 = return_xy_low_point(lines[r_i], img_h);
+        }
 
-            // Находим точку на нижней части линии справа от центра изображения
-            l_i = lines.size()-1;
-            cv::Point xy1 = return_xy_low_point(lines[l_i], img_h);
-            while (((xy1.x > Center_img) || (xy1.x == 0))) {
-                if (static_cast<int>(l_i) - 1 >= 0) {
-                    l_i--;
-                } else {
-                    xy1 = return_xy_low_point(lines[l_i], img_h);
-                    break;
-                }
+        // Находим точку на нижней части линии справа от центра изображения
+        l_i = lines.size()-1;
+        cv::Point xy1 = return_xy_low_point(lines[l_i], img_h);
+        while (((xy1.x > Center_img) || (xy1.x == 0))) {
+            if (static_cast<int>(l_i) - 1 >= 0) {
+                l_i--;
+            } else {
                 xy1 = return_xy_low_point(lines[l_i], img_h);
+                break;
             }
-
-            // Рисуем r точку в центре изображения
-            cv::circle(image, {Center_img, image.rows}, 20, cv::Scalar(0, 0, 255), 10);
-            // Задаем координаты точек для левой и правой границы дороги на изображении
-
-            buf.push_back({xy1});
-            buf.push_back({xy2});
-            buf.push_back({cv::Point(Center_img, img_h)});
-
-            return_three_vec_point_in_img_coord(buf);
-            Point_on_image_left<< static_cast<double>(buf[0][0].x), static_cast<double>(buf[0][0].y), 1.0;
-            Point_on_image_right<< static_cast<double>(buf[0][1].x), static_cast<double>(buf[0][1].y), 1.0;
+            xy1 = return_xy_low_point(lines[l_i], img_h);
         }
 
+        // Задаем координаты точек для левой и правой границы дороги и центра на изображении
+        cv::Point left = point_to_img_coord(xy1, Minv);
+        cv::Point right = point_to_img_coord(xy2, Minv);
+        cv::Point center = point_to_img_coord(cv::Point(Center_img, img_h), Minv);
+        Point_on_image_left << static_cast<double>(left.x), static_cast<double>(left.y), 1.0;
+        Point_on_image_right << static_cast<double>(right.x), static_cast<double>(right.y), 1.0;
+
         // Задаем мировые координаты для центра изображения и точек на изображении
-        worldCenter << buf[0][2].x, buf[0][2].y , 1.0;
+        worldCenter << center.x, center.y, 1.0;
         worldCenter = transformationMatrix * worldCenter;
 
         worldCoordinates1 = transformationMatrix * Point_on_image_left;
@@ -205,44 +192,18 @@ namespace RansacNamespace{
         right_distance = sqrt(pow(worldCenter(0) - worldCoordinates2(0), 2) + pow(worldCenter(1) - worldCoordinates2(1), 2));
         left_right_distance = {left_distance, right_distance}; // Обновляем расстояния
 
-        // Очищаем вектор и добавляем три точки для каждой из линий дороги
-        Three_points_to_line.clear();
-        Three_points_to_line.push_back(three_dots_l_r(img_h, img_h/2, 0, lines[l_i]));
-        Three_points_to_line.push_back(three_dots_l_r(img_h, img_h/2, 0, lines[r_i]));
-
-        return_three_vec_point_in_img_coord(Three_points_to_line);
-
-        std::vector<cv::Point2d> dist;
-
-        buf.clear();
-        for (double i=1; i>=0; i-=(0.5))
-            buf.push_back({cv::Point(Center_img, static_cast<int>(img_h*i))});
-
-        return_three_vec_point_in_img_coord(buf);
-
-        for (size_t j = 0; j<2 ; j++) {
-            dist.clear();
-            double image_rows = image.rows;
-            for (size_t i = 0; i != 3; i++) {
-                dist.push_back(find_distance_point_to_center(cv::Point2d(worldCenter(0), worldCenter(1)),
-                                                             Three_points_to_line[j][i]));
-                image_rows -= image.rows / 2;
-                worldCenter << buf[0][0].x, buf[0][0].y, 1.0;
-                worldCenter = transformationMatrix * worldCenter;
+        // Три точки (низ, середина, верх изображения) для левой и правой линии дороги
+        const size_t line_index[2] = {l_i, r_i};
+        const int rows[3] = {img_h, img_h / 2, 0};
+        three_points.resize(2);
+        for (size_t j = 0; j < 2; j++) {
+            three_points[j].resize(3);
+            for (size_t i = 0; i < 3; i++) {
+                cv::Point point = point_to_img_coord(return_xy_low_point(lines[line_index[j]], rows[i]), Minv);
+                three_points[j][i] = find_distance_point_to_center(cv::Point2d(worldCenter(0), worldCenter(1)),
+                                                                   point, transformationMatrix);
             }
-            retThree_points_to_line.push_back(dist);
-        }
-        dist.clear();
-        std::cout<<"\n\nleft points: ";
-        for(auto j : retThree_points_to_line[0]){
-            std::cout<<j<<"  ||   ";
-        }
-        std::cout<<"\nright points: ";
-        for(auto j : retThree_points_to_line[1]){
-            std::cout<<j<<"  ||   ";
         }
-        std::cout<<"\n\n";
-        return retThree_points_to_line;
     }
 
-}
\ No newline at end of file
+}
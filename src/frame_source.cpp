@@ -0,0 +1,190 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * wrap_frame - заголовок cv::Mat на память внешнего кадра (без копирования).
+ * BGR - CV_8UC3 размером кадра, NV12 и I420 - CV_8UC1 высотой 3/2 кадра, как у cv::VideoCapture
+ * с отключённым переводом в BGR.
+ *
+ * @param frame - внешний кадр.
+ * @param out - заголовок на память кадра.
+ * @return false, если указатель пустой, размер не подходит к формату или шаг строки меньше ширины.
+ */
+    bool wrap_frame(const external_frame& frame, cv::Mat& out) {
+        bool yuv = frame.format != frame_format::bgr;
+        size_t row_bytes = static_cast<size_t>(std::max(frame.width, 0)) * (yuv ? 1 : 3);
+        if ((frame.data == nullptr) || (frame.width <= 0) || (frame.height <= 0) || (frame.stride < row_bytes) ||
+            (yuv && ((frame.width % 2 != 0) || (frame.height % 2 != 0) || (frame.stride % 2 != 0)))) {
+            std::cout << "Ошибка: внешний кадр " << frame.width << "x" << frame.height << " с шагом строки "
+                      << frame.stride << " не подходит к формату" << std::endl;
+            return false;
+        }
+        if (yuv)
+            out = cv::Mat(frame.height / 2 * 3, frame.width, CV_8UC1, frame.data, frame.stride);
+        else
+            out = cv::Mat(frame.height, frame.width, CV_8UC3, frame.data, frame.stride);
+        return true;
+    }
+
+/**
+ * release_frame - возвращает буфер кадра владельцу (не больше одного раза).
+ */
+    void release_frame(external_frame& frame) {
+        if (frame.release) {
+            frame.release();
+            frame.release = nullptr;
+        }
+        frame.data = nullptr;
+    }
+
+
+    frame_pool::frame_pool(size_t size) : buffers(std::max<size_t>(size, 1)),
+                                          busy(new std::atomic<bool>[buffers.size()]) {
+        for (size_t i = 0; i < buffers.size(); i++)
+            busy[i].store(false, std::memory_order_relaxed);
+    }
+
+    size_t frame_pool::acquire() {
+        auto any_free = [this]() {
+            for (size_t i = 0; i < buffers.size(); i++) {
+                if (!busy[i].load(std::memory_order_acquire))
+                    return true;
+            }
+            return false;
+        };
+        while (true) {
+            for (size_t i = 0; i < buffers.size(); i++) {
+                bool expected = false;
+                if (busy[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    return i;
+            }
+            released.wait(any_free);
+        }
+    }
+
+    void frame_pool::release(size_t i) {
+        busy[i].store(false, std::memory_order_release);
+        released.notify();
+    }
+
+    cv::Mat& frame_pool::buffer(size_t i) {
+        return buffers[i];
+    }
+
+/**
+ * Кадр на память буфера. Размер кадра YUV восстанавливается из высоты буфера (3/2 кадра).
+ */
+    external_frame frame_pool::lease(size_t i, frame_format format, int64_t timestamp_ns) {
+        const cv::Mat &b = buffers[i];
+        external_frame frame;
+        frame.data = b.data;
+        frame.stride = b.step;
+        frame.width = b.cols;
+        frame.height = (format == frame_format::bgr) ? b.rows : b.rows / 3 * 2;
+        frame.format = format;
+        frame.timestamp_ns = timestamp_ns;
+        frame.release = [this, i]() { release(i); };
+        return frame;
+    }
+
+
+    video_source::video_source(const std::string& name, frame_format frame_fmt, size_t buffers)
+            : video(name), format(frame_fmt), pool(buffers) {
+        if (!video.isOpened())
+            std::cout << "Ошибка: не удалось открыть видео " << name << std::endl;
+        else if (format != frame_format::bgr)
+            video.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    }
+
+    bool video_source::is_open() const {
+        return video.isOpened();
+    }
+
+/**
+ * Декодирует кадр в свободный буфер пула. Буфер, не удерживаемый потребителем,
+ * cv::VideoCapture::read() заполняет на месте, без выделения памяти.
+ */
+    bool video_source::next(external_frame& frame) {
+        size_t i = pool.acquire();
+        cv::Mat &b = pool.buffer(i);
+        if (!video.read(b) || b.empty()) {
+            pool.release(i);
+            return false;
+        }
+        frame = pool.lease(i, format, lane_shm_now_ns());
+        return true;
+    }
+
+    cv::VideoCapture& video_source::capture() {
+        return video;
+    }
+
+
+    synthetic_source::synthetic_source(const settings& config, const synthetic_params& params, uint64_t frame_count,
+                                       frame_format frame_fmt, size_t buffers)
+            : road(config, params), frames(frame_count), format(frame_fmt), pool(buffers) {}
+
+    bool synthetic_source::next(external_frame& frame) {
+        if (rendered >= frames)
+            return false;
+        size_t i = pool.acquire();
+        cv::Mat &b = pool.buffer(i);
+        if (format == frame_format::bgr) {
+            road.render(rendered, b, last_truth, solid);
+        } else {
+            road.render(rendered, bgr, last_truth, solid);
+            cv::cvtColor(bgr, b, cv::COLOR_BGR2YUV_I420);
+            if (format == frame_format::nv12) {
+                // Чередование U и V на месте: I420 и NV12 отличаются только плоскостями цветности.
+                cv::Mat luma_rows = b.rowRange(0, b.rows / 3 * 2);
+                size_t plane = b.total() / 6;
+                interleaved.resize(2 * plane);
+                const uint8_t *u = b.ptr<uint8_t>(luma_rows.rows);
+                for (size_t k = 0; k < plane; k++) {
+                    interleaved[2 * k] = u[k];
+                    interleaved[2 * k + 1] = u[plane + k];
+                }
+                std::copy(interleaved.begin(), interleaved.end(), b.ptr<uint8_t>(luma_rows.rows));
+            }
+        }
+        rendered++;
+        frame = pool.lease(i, format, lane_shm_now_ns());
+        return true;
+    }
+
+    const lane_polys& synthetic_source::truth() const {
+        return last_truth;
+    }
+
+
+    external_source::external_source(size_t capacity) : queue(capacity) {}
+
+    bool external_source::push(const external_frame& frame) {
+        if (!queue.push(frame))
+            return false;
+        arrived.notify();
+        return true;
+    }
+
+    void external_source::close() {
+        closed.store(true, std::memory_order_release);
+        arrived.notify();
+    }
+
+/**
+ * Ждёт кадр, как этапы lane_pipeline (сон до push() или close()). Флаг закрытия ставится после последнего push,
+ * поэтому после него очередь проверяется ещё раз.
+ */
+    bool external_source::next(external_frame& frame) {
+        while (true) {
+            if (queue.pop(frame))
+                return true;
+            if (closed.load(std::memory_order_acquire))
+                return queue.pop(frame);
+            arrived.wait([this]() { return !queue.empty() || closed.load(std::memory_order_acquire); });
+        }
+    }
+
+}
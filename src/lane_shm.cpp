@@ -0,0 +1,236 @@
+#include "../include/lane_shm.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RansacNamespace {
+
+
+    int64_t lane_shm_now_ns() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+
+    static size_t segment_size(uint32_t capacity) {
+        return sizeof(lane_shm_header) + sizeof(lane_shm_slot) * capacity;
+    }
+
+
+    lane_shm_publisher::~lane_shm_publisher() {
+        close();
+    }
+
+/**
+ * Создает новый сегмент разделяемой памяти. Сегмент с тем же именем (от предыдущего запуска)
+ * не очищается, а удаляется из пространства имён: подключённые к нему читатели сохраняют
+ * отображение и последние данные, новые читатели подключаются к новому сегменту.
+ *
+ * @param name - имя сегмента POSIX ("/lanes").
+ * @param capacity - количество слотов в кольце.
+ * @return true, если сегмент создан.
+ */
+    bool lane_shm_publisher::open(const std::string& name, uint32_t capacity) {
+        close();
+        if (capacity == 0)
+            capacity = 1;
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if ((fd < 0) && (errno == EEXIST)) {
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        }
+        if (fd < 0) {
+            std::cout << "Ошибка: не удалось создать сегмент " << name << std::endl;
+            return false;
+        }
+        size_t size = segment_size(capacity);
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cout << "Ошибка: не удалось задать размер сегмента " << name << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED) {
+            std::cout << "Ошибка: не удалось отобразить сегмент " << name << std::endl;
+            return false;
+        }
+
+        // Новый сегмент после ftruncate заполнен нулями.
+        shm_name = name;
+        map_size = size;
+        base = mem;
+        header = static_cast<lane_shm_header*>(mem);
+        slots = reinterpret_cast<lane_shm_slot*>(static_cast<char*>(mem) + sizeof(lane_shm_header));
+        header->capacity = capacity;
+        header->slot_size = static_cast<uint32_t>(sizeof(lane_shm_slot));
+        header->version = lane_shm_version;
+        header->write_seq.store(0, std::memory_order_relaxed);
+        next_seq = 1;
+
+        // magic записывается последним: читатель не подключится к недописанному заголовку.
+        header->magic.store(lane_shm_magic, std::memory_order_release);
+        return true;
+    }
+
+/**
+ * Отключает и удаляет сегмент. Уже подключенные читатели продолжают видеть последние данные.
+ */
+    void lane_shm_publisher::close() {
+        if (base != nullptr) {
+            munmap(base, map_size);
+            shm_unlink(shm_name.c_str());
+        }
+        base = nullptr;
+        header = nullptr;
+        slots = nullptr;
+        map_size = 0;
+    }
+
+    bool lane_shm_publisher::is_open() const {
+        return base != nullptr;
+    }
+
+/**
+ * Публикует кадр. Писатель не ждёт читателей: слот помечается нечётным seq на время записи.
+ *
+ * @param frame - модель полос кадра.
+ */
+    void lane_shm_publisher::publish(lane_shm_frame& frame) {
+        if (base == nullptr)
+            return;
+        uint64_t seq = next_seq++;
+        frame.sequence = seq;
+        frame.publish_ns = lane_shm_now_ns();
+
+        lane_shm_slot &slot = slots[seq % header->capacity];
+        uint64_t words[lane_shm_words];
+        std::memcpy(words, &frame, sizeof(frame));
+
+        slot.seq.store(2 * seq - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < lane_shm_words; i++)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.seq.store(2 * seq, std::memory_order_release);
+
+        header->write_seq.store(seq, std::memory_order_release);
+    }
+
+
+
+    lane_shm_reader::~lane_shm_reader() {
+        close();
+    }
+
+/**
+ * Подключается к сегменту только для чтения.
+ *
+ * @param name - имя сегмента POSIX.
+ * @return true, если сегмент найден и имеет совместимую версию.
+ */
+    bool lane_shm_reader::open(const std::string& name) {
+        close();
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+
+        struct stat st{};
+        if ((fstat(fd, &st) != 0) || (static_cast<size_t>(st.st_size) < sizeof(lane_shm_header))) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void *mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED)
+            return false;
+
+        const auto *head = static_cast<const lane_shm_header*>(mem);
+        if ((head->magic.load(std::memory_order_acquire) != lane_shm_magic) || (head->version != lane_shm_version) ||
+            (head->slot_size != sizeof(lane_shm_slot)) || (size < segment_size(head->capacity))) {
+            munmap(mem, size);
+            return false;
+        }
+
+        map_size = size;
+        base = mem;
+        header = head;
+        slots = reinterpret_cast<const lane_shm_slot*>(static_cast<const char*>(mem) + sizeof(lane_shm_header));
+        return true;
+    }
+
+    void lane_shm_reader::close() {
+        if (base != nullptr)
+            munmap(base, map_size);
+        base = nullptr;
+        header = nullptr;
+        slots = nullptr;
+        map_size = 0;
+    }
+
+    bool lane_shm_reader::is_open() const {
+        return base != nullptr;
+    }
+
+    uint64_t lane_shm_reader::last_sequence() const {
+        if (base == nullptr)
+            return 0;
+        return header->write_seq.load(std::memory_order_acquire);
+    }
+
+/**
+ * Читает последний опубликованный кадр. Если кадр был перезаписан во время чтения,
+ * берётся следующий последний.
+ */
+    bool lane_shm_reader::read_latest(lane_shm_frame& out) const {
+        while (true) {
+            uint64_t seq = last_sequence();
+            if (seq == 0)
+                return false;
+            if (read(seq, out) == 1)
+                return true;
+        }
+    }
+
+/**
+ * Читает кадр с заданным номером без блокировки писателя.
+ *
+ * @param sequence - номер публикации.
+ * @param out - прочитанный кадр.
+ * @return 1 - прочитан, 0 - ещё не опубликован, -1 - уже перезаписан новым кадром.
+ */
+    int lane_shm_reader::read(uint64_t sequence, lane_shm_frame& out) const {
+        if ((base == nullptr) || (sequence == 0))
+            return 0;
+        const lane_shm_slot &slot = slots[sequence % header->capacity];
+        uint64_t words[lane_shm_words];
+
+        while (true) {
+            uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+            if (s1 < 2 * sequence - 1)
+                return 0;
+            if (s1 > 2 * sequence)
+                return -1;
+            if (s1 & 1)
+                continue; // Идёт запись этого кадра.
+
+            for (size_t i = 0; i < lane_shm_words; i++)
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t s2 = slot.seq.load(std::memory_order_relaxed);
+            if (s1 == s2) {
+                std::memcpy(&out, words, sizeof(out));
+                return 1;
+            }
+        }
+    }
+
+}
@@ -1,152 +1,216 @@
 #include "../include/Ransac.h"
 
-int main() {
+#include <csignal>
 
-    RansacNamespace::settings init;
+/// Запрос вывода гистограмм задержек (SIGUSR1).
+static volatile std::sig_atomic_t report_requested = 0;
+/// Запрос выгрузки трассировки (SIGUSR2).
+static volatile std::sig_atomic_t trace_requested = 0;
+
+static void on_report_signal(int) {
+    report_requested = 1;
+}
 
-    // Создание объекта для обработки изображения птичьего вида и настройки его параметров.
-    RansacNamespace::Bird_view bird_img;
-    bird_img.get_parameters(init.video_name);
-
-    // Создание объекта для обработки изображения HSV и настройки его параметров.
-    RansacNamespace::hsv hsv_img;
-    RansacNamespace::hsv::get_parameters(init.video_name);
-    // Открытие видеопотока.
-    cv::VideoCapture vid(init.video_name);
-    if (!vid.isOpened()) {
-        std::cout<< "Ошибка: не удалось открыть камеру." << std::endl;
+static void on_trace_signal(int) {
+    trace_requested = 1;
+}
+
+/**
+ * Использование: RANSAC2 [файл конфигурации] [видео] [--step] [--perf] [--trace файл] [--pipeline N] [--synthetic N]
+ *
+ * Параметры читаются из одного файла конфигурации (по умолчанию ../data/config.yaml).
+ * Настройка bird и HSV параметров выполняется отдельной программой lane_tune.
+ * --step - ожидание нажатия клавиши после каждого кадра.
+ * --perf - аппаратные счётчики (perf_event) по этапам: IPC, промахи кэша и ошибки предсказания переходов на кадр.
+ * --trace - запись временной шкалы этапов, выгрузка в Chrome trace JSON при завершении и по сигналу SIGUSR2
+ *           (открывается в chrome://tracing или ui.perfetto.dev).
+ * --pipeline - конвейерная обработка в трёх потоках (чтение, front_end, back_end), N - кадров в обработке
+ *              одновременно. Выводятся кадры в секунду и задержка кадра от чтения до результата.
+ * --synthetic - вместо видео N синтетических кадров дороги (synthetic_road) размером 1280x720.
+ * Задержки по этапам выводятся при завершении и по сигналу SIGUSR1.
+ * При metrics_port > 0 метрики доступны по адресу http://127.0.0.1:metrics_port/metrics (формат Prometheus).
+ */
+int main(int argc, char** argv) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::string config_path = "../data/config.yaml";
+    std::string video_name;
+    bool step = false;
+    bool perf = false;
+    std::string trace_path;
+    size_t pipeline_depth = 0;
+    uint64_t synthetic_frames = 0;
+    size_t positional = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--step")
+            step = true;
+        else if (arg == "--perf")
+            perf = true;
+        else if ((arg == "--trace") && (i + 1 < argc))
+            trace_path = argv[++i];
+        else if ((arg == "--pipeline") && (i + 1 < argc))
+            pipeline_depth = std::stoul(argv[++i]);
+        else if ((arg == "--synthetic") && (i + 1 < argc))
+            synthetic_frames = std::stoull(argv[++i]);
+        else if (positional++ == 0)
+            config_path = arg;
+        else
+            video_name = arg;
+    }
+
+    RansacNamespace::settings init;
+    if (!init.load(config_path))
+        return 1;
+    if (!video_name.empty())
+        init.video_name = video_name;
+
+    // Кадры YUV передаются детектору как есть, в BGR переводятся только для отображения.
+    RansacNamespace::frame_format input_format = RansacNamespace::frame_format::bgr;
+    RansacNamespace::parse_frame_format(init.input_format, input_format);
+    cv::Mat display_frame;
+
+    // Источник кадров: видео или синтетическая дорога. Кадры не копируются, буферов больше,
+    // чем кадров в обработке, поэтому чтение не ждёт освобождения буфера.
+    size_t frame_buffers = std::max<size_t>(pipeline_depth, 3) + 1;
+    std::unique_ptr<RansacNamespace::frame_source> source;
+    if (synthetic_frames > 0) {
+        source = std::make_unique<RansacNamespace::synthetic_source>(init, RansacNamespace::synthetic_params{},
+                                                                     synthetic_frames, input_format, frame_buffers);
+    } else {
+        auto video = std::make_unique<RansacNamespace::video_source>(init.video_name, input_format, frame_buffers);
+        if (!video->is_open())
+            return 1;
+        source = std::move(video);
     }
 
     cv::namedWindow("fif1");
+    RansacNamespace::external_frame input;
     cv::Mat img;
-    cv::Mat hsv;
-    cv::Mat bird;
-    RansacNamespace::TL lines;
-    std::vector<int> I1(init.cout_stripes);
-    std::vector<int> I2(init.cout_stripes);
-    std::vector<bool> buffBoolList(init.cout_stripes);
-    std::vector<std::vector<cv::Point>> polygon(0);
-    polygon = {{{}}};
-    std::vector<bool> result_type_of_lines(init.cout_stripes);
-    // Инициализация массивов и параметров.
-    for (size_t i = 0; i < init.cout_stripes; i++) {
-        I1[i] = 0;
-    }
-    for (size_t i = 0; i < init.cout_stripes; i++) {
-        I2[i] = 999;
+    cv::Mat line_image;
+
+    RansacNamespace::LaneDetector detector(init);
+    RansacNamespace::LaneDetector::Result result;
+    // Регулятор качества держит время кадра target_frame_ms (при 0 ничего не меняет).
+    RansacNamespace::quality_controller quality(init);
+    if (perf)
+        detector.profiler().enable_counters();
+    if (!trace_path.empty()) {
+        RansacNamespace::trace::enable(1 << 16);
+        RansacNamespace::trace::set_thread_name("main");
     }
-    for (size_t i = 0; i < init.cout_stripes; i++) {
-        buffBoolList[i] = true;
-    }
-
-    cv::Scalar textColor = {0, 0, 0};
-    cv::Point textPosition = {100, 100};
-    size_t iteration = 0;
 
-    std::vector<double> left_right_distance;
-
-    // Создание контейнера для хранения результатов обработки.
-    RansacNamespace::container cont (init.cout_containers, init.cout_stripes, static_cast<size_t>( init.parametersBird[9]));
-    RansacNamespace::container cont_poly (init.cout_containers, init.cout_stripes, static_cast<size_t>( init.parametersBird[9]));
-
-    std::vector<cv::Mat> matrixBird;
+    // Асинхронная запись телеметрии: в цикле запись только копируется в очередь.
+    RansacNamespace::telemetry telemetry(RansacNamespace::telemetry_encoder::create(init.telemetry_format),
+                                         init.telemetry_path, init.telemetry_rate_hz, init.telemetry_queue_size);
+    RansacNamespace::frame_record record{};
+
+    // Публикация результатов для внешних процессов через разделяемую память.
+    RansacNamespace::lane_shm_publisher publisher;
+    RansacNamespace::lane_shm_frame shm_frame{};
+    if (!init.shm_name.empty())
+        publisher.open(init.shm_name, init.shm_capacity);
+
+    // Метрики Prometheus на 127.0.0.1:metrics_port: сервер в своём потоке читает только атомарные счётчики.
+    RansacNamespace::lane_metrics metrics(detector);
+    std::unique_ptr<RansacNamespace::metrics_server> metrics_server;
+    if (init.metrics_port > 0)
+        metrics_server = std::make_unique<RansacNamespace::metrics_server>(metrics, static_cast<uint16_t>(init.metrics_port));
+
+    std::signal(SIGUSR1, on_report_signal);
+    std::signal(SIGUSR2, on_trace_signal);
     std::cout << std::endl << "Запуск обнаружения линий..." << std::endl << std::endl;
 
-    while (cv::waitKey(1) != 'q') {
-        mrpt::system::CTicTac tictac; // Таймер для измерения времени выполнения.
-
-        if (iteration < 20) {
-            iteration++;
-        } // общий итератор цикла
-        vid.read(img);
-
-        // Получение вектора определяющего ширину полос, на которые потом будет делиться изображение
-        std::vector<cv::Point2d> vec_container_stripes = init.get_vector_stripes_width(cont.width_stripes);
-
-        if (iteration == 1) {
-            // Получние матрицы преобразования в Птичью перспективу
-            matrixBird = bird_img.return_bird_matrix(init.parametersBird);
+    // Отображение и публикация результата кадра. Возвращает false, если нажата клавиша выхода.
+    auto show_result = [&](const cv::Mat& img, const RansacNamespace::LaneDetector::Result& result,
+                           int64_t capture_ns, double frame_time) {
+        if (result.frame == 0) {
+            // Время от запуска программы до первого обработанного кадра.
+            std::chrono::duration<double, std::milli> startup = std::chrono::steady_clock::now() - start_time;
+            std::cout << "Время запуска до первого кадра: " << startup.count() << " мс" << std::endl;
         }
 
-
-        bird = bird_img.warpImage(img, img, matrixBird, init.parametersBird, 'n'); // Приенение матрицы
-        hsv = hsv_img.return_hsv(bird, init.parametersHSV); // получение полутонового изображения
-        std::vector<std::vector<cv::Point>> contours = {};
-        std::vector<cv::Point> coord = {};
-        //фильтрация полученных контуров
-        hsv_img.filtered_img(hsv, contours, coord);
-
-        cv::Mat test_img = cv::Mat::zeros(hsv.size(), hsv.type());
-        cv::drawContours(test_img, contours, -1, cv::Scalar(255, 255, 255), -1);
-
-//        RansacNamespace::draw_inliers(bird, coord);
-
-        // Применение RANSAC для обнаружения линий.
-        lines = RansacNamespace::RANSACLines(coord, init.min_inliers, init.Dist_threshold);
-
-        // Удаление наклонных линий.
-        RansacNamespace::rm_slanted_lines(lines);
-        //Разделить изображение на полосы и выделить в каждой из них свою линию разметки
-        RansacNamespace::division_into_stripes(lines, cont, vec_container_stripes);
-
-        // Поиск координат для нахождения полиномов.
-        std::vector<std::vector<cv::Point>> coord_for_lines;
-        RansacNamespace::find_x_y(lines, contours, init.width_line_search, coord_for_lines, result_type_of_lines);
-        //Расчёт полиномов из полученных ранее координат
-        RansacNamespace::TL Polylines = RansacNamespace::x_y_to_polynom(coord_for_lines);
-
-
-        // Добавление результатов в контейнер и нормализация данных.
-        cont_poly.add_to_container(Polylines, cont_poly.contain);
-        if (iteration > 10)
-            cont_poly.normalizeData(cont_poly.contain, I1, buffBoolList, I2, init.sense_to_normolize_data);
-
-        // Вывод параметров полинома и отображение карты дороги.
-        RansacNamespace::cout_line(cont_poly, init.cout_containers-1);
-        std::cout << "\n";
-
-        RansacNamespace::show_road_map(cont_poly, init.cout_containers-1, result_type_of_lines);
-
-
-        // Отображение линий и пространства дороги.
-        cv::Mat line_image = cv::Mat::zeros(bird.size(), bird.type());
-        RansacNamespace::draw_lines(line_image, Polylines, true, result_type_of_lines);
-//        RansacNamespace::draw_lines(bird, lines, false, result_type_of_lines);
-
-        //Получение дистанции до левой и правой полосы
-
-
-        std::vector<std::vector<cv::Point2d>> Three_points = RansacNamespace:: get_three_point_vector(Polylines, line_image, init.transformationMatrix, left_right_distance);
-
-        bool lines_detected = RansacNamespace::lines_found(Polylines);
-        std::cout<< "; Значение lines_detected: "<< lines_detected;
-
-        //Применение матрицы преобразования в обратном режиме
-        cv::imshow("fif2", bird);
-        line_image = bird_img.warpImage(line_image, img, matrixBird, init.parametersBird , 'r');
-        line_image = line_image + img;
-
-        // Отображение информации о расстоянии.
-        std::stringstream ss1;
-        textPosition = {400, 100};
-        ss1 << std::fixed << std::setprecision(2) << left_right_distance[0];
-        std::string numberString1 = ss1.str();
-        putText(line_image,  "left "+numberString1+" m", textPosition, cv::FONT_HERSHEY_SIMPLEX, init.fontSize, textColor, init.thickness);
-
-        std::stringstream ss2;
-        textPosition.y += 50;
-        ss2 << std::fixed << std::setprecision(2) << left_right_distance[1];
-        std::string numberString2 = ss2.str();
-        putText(line_image, "right "+numberString2+" m", textPosition, cv::FONT_HERSHEY_SIMPLEX, init.fontSize, textColor, init.thickness);
+        // Отображение линий и расстояний поверх кадра.
+        cv::imshow("fif2", result.bird);
+        if (input_format == RansacNamespace::frame_format::bgr)
+            display_frame = img;
+        else
+            cv::cvtColor(img, display_frame, input_format == RansacNamespace::frame_format::nv12
+                                             ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2BGR_I420);
+        detector.render(display_frame, result, line_image);
         cv::imshow("fif1", line_image);
 
-        RansacNamespace::show_left_right_dist(left_right_distance);
-
-        std::cout << "\n Время вычислений для одного кадра: " << tictac.Tac()  << " с" << std::endl;
-        std::cout << std::endl << std::endl << "/" << std::string(100,'-') << "/" << std::endl;
-        cv::waitKey(0);
+        // Параметры полиномов, типы линий, расстояния и время кадра передаются в телеметрию.
+        RansacNamespace::fill_frame_record(record, result.frame, result.smoothed, result.types,
+                                           result.lines_detected, result.left_right_distance,
+                                           result.three_points, frame_time);
+        telemetry.publish(record);
+        if (quality.update(frame_time, detector.profiler(), std::cout))
+            detector.set_quality(quality.knobs());
+        if (metrics_server) {
+            metrics.record(result);
+            metrics.set_quality_level(quality.level());
+            metrics.set_dropped(telemetry.dropped());
+        }
+        if (publisher.is_open()) {
+            RansacNamespace::fill_shm_frame(shm_frame, record, capture_ns);
+            publisher.publish(shm_frame);
+        }
+        if (report_requested) {
+            report_requested = 0;
+            detector.profiler().report(std::cout);
+        }
+        if (trace_requested) {
+            trace_requested = 0;
+            if (!trace_path.empty())
+                RansacNamespace::trace::dump(trace_path);
+        }
+        if (step)
+            cv::waitKey(0);
+        return cv::waitKey(1) != 'q';
+    };
+
+    if (pipeline_depth > 0) {
+        // Кадры читаются и обрабатываются в фоновых потоках, здесь - только отображение.
+        RansacNamespace::lane_pipeline pipeline(detector, *source, pipeline_depth);
+        while (RansacNamespace::lane_pipeline::slot *s = pipeline.next()) {
+            // Время обработки без ожидания в очередях: по нему работают телеметрия и регулятор качества.
+            std::chrono::duration<double> frame_time = s->processing;
+            bool proceed = show_result(s->frame, s->result, s->capture_ns, frame_time.count());
+            pipeline.release(s);
+            if (!proceed)
+                break;
+        }
+        pipeline.stop();
+        pipeline.report(std::cout);
+    } else {
+        while (true) {
+            mrpt::system::CTicTac tictac; // Таймер для измерения времени выполнения.
+
+            {
+                LANE_STAGE_SCOPE(timer, detector.profiler(), capture);
+                if (!source->next(input))
+                    break;
+            }
+            if (!RansacNamespace::wrap_frame(input, img)) {
+                RansacNamespace::release_frame(input);
+                break;
+            }
+            int64_t capture_ns = (input.timestamp_ns != 0) ? input.timestamp_ns : RansacNamespace::lane_shm_now_ns();
+
+            detector.process(img, result);
+            bool proceed = show_result(img, result, capture_ns, tictac.Tac());
+            img.release();
+            RansacNamespace::release_frame(input);
+            if (!proceed)
+                break;
+        }
     }
 
+    detector.profiler().report(std::cout);
+    if (init.static_threshold > 0)
+        std::cout << "Кадров с неизменной сценой (повтор результата): " << detector.reused_frames() << std::endl;
+    if (!trace_path.empty())
+        RansacNamespace::trace::dump(trace_path);
     return 0;
 }
-
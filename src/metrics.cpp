@@ -0,0 +1,305 @@
+#include "../include/Ransac.h"
+
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RansacNamespace {
+
+
+    namespace {
+
+        /// Квантили сводок (summary) задержек этапов и точек на кадр.
+        const double summary_quantiles[] = {0.5, 0.9, 0.99};
+
+        /// Максимальный размер запроса: заголовки длиннее обрываются.
+        constexpr size_t max_request = 8192;
+
+        void family(std::ostream& out, const char* name, const char* type, const char* help) {
+            out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+        }
+
+        template<typename T>
+        void metric(std::ostream& out, const char* name, const char* type, const char* help, T value) {
+            family(out, name, type, help);
+            out << name << " " << value << "\n";
+        }
+
+        /// Сводка по гистограмме: квантили, сумма и количество. scale переводит значения в единицы метрики.
+        void summary(std::ostream& out, const char* name, const std::string& labels, const latency_histogram& h,
+                     double scale) {
+            std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+            for (double q : summary_quantiles)
+                out << name << prefix << "quantile=\"" << q << "\"} " << static_cast<double>(h.quantile(q)) * scale << "\n";
+            std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+            out << name << "_sum" << suffix << " " << static_cast<double>(h.sum()) * scale << "\n";
+            out << name << "_count" << suffix << " " << h.count() << "\n";
+        }
+
+        /// Создаёт сокет TCP с адресом 127.0.0.1:port.
+        int loopback_socket(uint16_t port, sockaddr_in& addr) {
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        }
+
+        /// Ограничение времени чтения и записи сокета, чтобы зависший клиент не останавливал сервер.
+        void set_timeout(int fd, int ms) {
+            timeval tv{};
+            tv.tv_sec = ms / 1000;
+            tv.tv_usec = (ms % 1000) * 1000;
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+
+        bool send_all(int fd, const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                    return false;
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+    }
+
+
+    lane_metrics::lane_metrics(LaneDetector& source) : detector(source) {}
+
+/**
+ * Учитывает результат кадра. Кадр с повтором результата неизменной сцены (result.reused) учитывается
+ * только в количестве кадров: полосы и точки у него не обрабатывались.
+ */
+    void lane_metrics::record(const LaneDetector::Result& result) {
+        frames.fetch_add(1, std::memory_order_relaxed);
+
+        // Сглаженный интервал между кадрами: окно порядка 16 кадров.
+        int64_t now = lane_shm_now_ns();
+        int64_t previous = last_frame_ns.exchange(now, std::memory_order_relaxed);
+        if (previous != 0) {
+            int64_t interval = frame_interval_ns.load(std::memory_order_relaxed);
+            interval = (interval == 0) ? now - previous : interval + (now - previous - interval) / 16;
+            frame_interval_ns.store(interval, std::memory_order_relaxed);
+        }
+
+        lines_detected.store(result.lines_detected ? 1 : 0, std::memory_order_relaxed);
+        uint32_t tracked_lines = 0;
+        for (auto &line : result.smoothed)
+            tracked_lines += line.found() ? 1u : 0u;
+        lines_tracked.store(tracked_lines, std::memory_order_relaxed);
+        if (result.lines_detected)
+            frames_with_lines.fetch_add(1, std::memory_order_relaxed);
+        if (result.reused)
+            return;
+
+        if (result.tracked)
+            tracked_frames.fetch_add(1, std::memory_order_relaxed);
+        points.record(result.points);
+        points_total.fetch_add(result.points, std::memory_order_relaxed);
+        uint64_t empty = 0;
+        for (auto &line : result.lines)
+            empty += line.found() ? 0u : 1u;
+        stripes_total.fetch_add(result.lines.size(), std::memory_order_relaxed);
+        empty_stripes_total.fetch_add(empty, std::memory_order_relaxed);
+    }
+
+    void lane_metrics::set_quality_level(size_t level) {
+        quality_level.store(static_cast<uint32_t>(level), std::memory_order_relaxed);
+    }
+
+    void lane_metrics::set_dropped(uint64_t records) {
+        dropped_records.store(records, std::memory_order_relaxed);
+    }
+
+/**
+ * Текст метрик. Доли (пустые полосы, кадры с линиями) не вычисляются: их дают отношения счётчиков
+ * в запросах Prometheus, например rate(lane_empty_stripes_total[1m]) / rate(lane_stripes_total[1m]).
+ */
+    void lane_metrics::expose(std::string& out) const {
+        std::ostringstream text;
+        auto load = [](const std::atomic<uint64_t>& counter) { return counter.load(std::memory_order_relaxed); };
+
+        metric(text, "lane_frames_total", "counter", "Обработанные кадры.", load(frames));
+        int64_t interval = frame_interval_ns.load(std::memory_order_relaxed);
+        metric(text, "lane_fps", "gauge", "Кадров в секунду (сглаженный интервал между кадрами).",
+               interval > 0 ? 1e9 / static_cast<double>(interval) : 0.0);
+        metric(text, "lane_frames_with_lines_total", "counter", "Кадры, в которых найдены линии (lines_found).",
+               load(frames_with_lines));
+        metric(text, "lane_lines_detected", "gauge", "1 - в последнем кадре найдены линии.",
+               lines_detected.load(std::memory_order_relaxed));
+        metric(text, "lane_stripes_total", "counter", "Полосы обработанных кадров.", load(stripes_total));
+        metric(text, "lane_empty_stripes_total", "counter", "Полосы, в которых линия не найдена.",
+               load(empty_stripes_total));
+        metric(text, "lane_points_total", "counter", "Точки, переданные в RANSAC.", load(points_total));
+        family(text, "lane_points_per_frame", "summary", "Точки RANSAC на обработанный кадр.");
+        summary(text, "lane_points_per_frame", "", points, 1);
+        metric(text, "lane_reused_frames_total", "counter",
+               "Кадры неизменной сцены, для которых повторён предыдущий результат (static_threshold).",
+               detector.reused_frames());
+        metric(text, "lane_telemetry_dropped_total", "counter", "Записи телеметрии, потерянные при переполнении очереди.",
+               load(dropped_records));
+        metric(text, "lane_tracked_frames_total", "counter", "Кадры, обработанные в полосах слежения (roi_margin).",
+               load(tracked_frames));
+        metric(text, "lane_tracked_lines", "gauge", "Сглаженные линии последнего кадра.",
+               lines_tracked.load(std::memory_order_relaxed));
+        metric(text, "lane_quality_level", "gauge", "Шаг снижения качества регулятором (0 - исходное качество).",
+               quality_level.load(std::memory_order_relaxed));
+
+        family(text, "lane_stage_latency_seconds", "summary", "Задержка этапов обработки кадра.");
+        stage_profiler &profiler = detector.profiler();
+        for (size_t i = 0; i < stage_count; i++) {
+            auto s = static_cast<stage>(i);
+            const latency_histogram &h = profiler.histogram(s);
+            if (h.count() > 0)
+                summary(text, "lane_stage_latency_seconds", std::string("stage=\"") + stage_name(s) + "\"", h, 1e-9);
+        }
+        out = text.str();
+    }
+
+
+/**
+ * Открывает сокет на 127.0.0.1:port и запускает поток сервера. Сервер слушает только петлевой
+ * интерфейс: метрики доступны локальному агенту Prometheus, но не сети.
+ */
+    metrics_server::metrics_server(const lane_metrics& source, uint16_t port) : metrics(source) {
+        sockaddr_in addr{};
+        listener = loopback_socket(port, addr);
+        if (listener < 0) {
+            std::cout << "Ошибка: не удалось создать сокет метрик: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        socklen_t len = sizeof(addr);
+        if ((bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) || (listen(listener, 8) != 0) ||
+            (getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) != 0)) {
+            std::cout << "Ошибка: не удалось открыть порт метрик 127.0.0.1:" << port << ": " << std::strerror(errno)
+                      << std::endl;
+            close(listener);
+            listener = -1;
+            return;
+        }
+        bound_port = ntohs(addr.sin_port);
+        running.store(true, std::memory_order_release);
+        worker = std::thread(&metrics_server::run, this);
+    }
+
+    metrics_server::~metrics_server() {
+        running.store(false, std::memory_order_release);
+        if (worker.joinable())
+            worker.join();
+        if (listener >= 0)
+            close(listener);
+    }
+
+    bool metrics_server::is_open() const {
+        return listener >= 0;
+    }
+
+    uint16_t metrics_server::port() const {
+        return bound_port;
+    }
+
+    uint64_t metrics_server::requests() const {
+        return served.load(std::memory_order_relaxed);
+    }
+
+    /// Ожидание соединений с проверкой флага остановки каждые 100 мс.
+    void metrics_server::run() {
+        trace::set_thread_name("metrics");
+        while (running.load(std::memory_order_acquire)) {
+            pollfd fd{listener, POLLIN, 0};
+            if (poll(&fd, 1, 100) <= 0)
+                continue;
+            int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0)
+                continue;
+            set_timeout(client, 1000);
+            serve(client);
+            close(client);
+        }
+    }
+
+/**
+ * Читает заголовки запроса и отвечает: GET /metrics - 200 с текстом метрик, другой путь - 404,
+ * другой метод - 405. Соединение закрывается после ответа (HTTP/1.0).
+ */
+    void metrics_server::serve(int client) {
+        std::string request;
+        char buf[1024];
+        while ((request.find("\r\n\r\n") == std::string::npos) && (request.size() < max_request)) {
+            ssize_t n = recv(client, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            request.append(buf, static_cast<size_t>(n));
+        }
+        std::string line = request.substr(0, request.find("\r\n"));
+        std::istringstream words(line);
+        std::string method, path;
+        words >> method >> path;
+        if (method.empty())
+            return;
+
+        std::string status = "200 OK";
+        if (method != "GET") {
+            status = "405 Method Not Allowed";
+            body = "method not allowed\n";
+        } else if (path.substr(0, path.find('?')) != "/metrics") {
+            status = "404 Not Found";
+            body = "not found\n";
+        } else {
+            metrics.expose(body);
+        }
+        std::string response = "HTTP/1.0 " + status + "\r\n"
+                               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n";
+        if (send_all(client, response) && send_all(client, body))
+            served.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+/**
+ * scrape_metrics - запрос GET /metrics к серверу метрик на 127.0.0.1:port (как опрос Prometheus).
+ *
+ * @param port - порт сервера.
+ * @param body - текст метрик.
+ * @return false, если соединение не установлено или ответ не 200.
+ */
+    bool scrape_metrics(uint16_t port, std::string& body) {
+        body.clear();
+        sockaddr_in addr{};
+        int fd = loopback_socket(port, addr);
+        if (fd < 0)
+            return false;
+        set_timeout(fd, 2000);
+        std::string response;
+        if ((connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) &&
+            send_all(fd, "GET /metrics HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n")) {
+            char buf[4096];
+            ssize_t n;
+            while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+                response.append(buf, static_cast<size_t>(n));
+        }
+        close(fd);
+
+        size_t header_end = response.find("\r\n\r\n");
+        // "HTTP/1.x 200" - не короче 12 символов, иначе compare(9, ...) выбросит out_of_range.
+        if ((response.size() < 12) || (response.compare(0, 5, "HTTP/") != 0) || (response.compare(9, 3, "200") != 0) ||
+            (header_end == std::string::npos)) {
+            std::cout << "Ошибка: нет ответа 200 от сервера метрик 127.0.0.1:" << port << std::endl;
+            return false;
+        }
+        body = response.substr(header_end + 4);
+        return true;
+    }
+
+}
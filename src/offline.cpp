@@ -0,0 +1,159 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+    namespace {
+
+        /// Часть видео: кадры [begin, end) и их записи.
+        struct chunk {
+            size_t begin = 0;
+            size_t end = 0;
+            std::vector<frame_record> records;
+            size_t warmup_frames = 0;
+            bool ok = true;
+            /// Текст исключения, прервавшего обработку части
+            std::string error;
+            std::atomic<bool> done{false};
+        };
+
+        /**
+         * Переход к кадру first. CAP_PROP_POS_FRAMES проверяется чтением: многие кодеки переходят
+         * к ближайшему ключевому кадру. Если позиция не совпала, кадры декодируются с начала видео.
+         */
+        void seek(cv::VideoCapture& video, size_t first) {
+            if (first == 0)
+                return;
+            if (video.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(first)) &&
+                (std::abs(video.get(cv::CAP_PROP_POS_FRAMES) - static_cast<double>(first)) < 0.5))
+                return;
+            video.set(cv::CAP_PROP_POS_FRAMES, 0);
+            for (size_t i = 0; (i < first) && video.grab(); i++) {}
+        }
+
+        /**
+         * Обрабатывает часть: переход к кадру begin - warmup, обработка по порядку до end (или до конца видео).
+         * Исключения OpenCV и нехватка памяти не выходят из потока: часть помечается ошибкой.
+         */
+        void run_chunk(const settings& init, frame_format format, size_t warmup, chunk& part) {
+            size_t first = part.begin > warmup ? part.begin - warmup : 0;
+            try {
+                video_source source(init.video_name, format, 1);
+                if (!source.is_open()) {
+                    part.ok = false;
+                    part.done.store(true, std::memory_order_release);
+                    return;
+                }
+                seek(source.capture(), first);
+
+                LaneDetector detector(init);
+                LaneDetector::Result result;
+                external_frame input;
+                cv::Mat frame;
+                if (part.end != SIZE_MAX)
+                    part.records.reserve(part.end - part.begin);
+                for (size_t index = first; index < part.end; index++) {
+                    if (!source.next(input))
+                        break;
+                    if (!wrap_frame(input, frame)) {
+                        release_frame(input);
+                        part.ok = false;
+                        break;
+                    }
+                    auto begin = std::chrono::steady_clock::now();
+                    detector.process(frame, result);
+                    std::chrono::duration<double> frame_time = std::chrono::steady_clock::now() - begin;
+                    frame.release();
+                    release_frame(input);
+
+                    if (index < part.begin) {
+                        part.warmup_frames++;
+                        continue;
+                    }
+                    part.records.emplace_back();
+                    fill_frame_record(part.records.back(), index, result.smoothed, result.types, result.lines_detected,
+                                      result.left_right_distance, result.three_points, frame_time.count());
+                }
+            } catch (const std::exception& e) {
+                part.ok = false;
+                part.error = e.what();
+            }
+            part.done.store(true, std::memory_order_release);
+        }
+    }
+
+
+/**
+ * process_offline - обработка видео init.video_name частями в параллельных потоках.
+ * Записи кадров передаются в output по порядку номеров кадров: записи части выдаются, как только
+ * готовы она и все предыдущие, поэтому в памяти хранятся только записи ещё не выданных частей.
+ *
+ * Результат совпадает с последовательной обработкой, если перекрытия хватает, чтобы сглаживание
+ * забыло начальное состояние (не меньше cout_containers и 10 кадров прогрева детектора), с точностью
+ * до случайной выборки точек RANSAC (проверка - test_offline_chunks). RANSAC частей выполняется
+ * по одному (общий генератор MRPT, см. RANSACLines), поэтому ускорение ограничено долей этапа ransac.
+ * Если количество кадров видео неизвестно, видео обрабатывается одной частью.
+ * Частей не больше количества ядер (std::thread::hardware_concurrency()) и количества кадров.
+ *
+ * @param init - параметры детекции и путь к видео.
+ * @param options - количество частей, перекрытие и ограничение количества кадров.
+ * @param output - приёмник записей (вызывается из вызывающего потока).
+ * @param stats - количество кадров, частей и время обработки.
+ * @return false, если видео не открылось, кадр не удалось обработать или при обработке части возникло исключение.
+ */
+    bool process_offline(const settings& init, const offline_options& options,
+                         const std::function<void(const frame_record&)>& output, offline_stats& stats) {
+        auto started = std::chrono::steady_clock::now();
+        frame_format format = frame_format::bgr;
+        parse_frame_format(init.input_format, format);
+
+        size_t total;
+        {
+            cv::VideoCapture probe(init.video_name);
+            if (!probe.isOpened()) {
+                std::cout << "Ошибка: не удалось открыть видео " << init.video_name << std::endl;
+                return false;
+            }
+            double count = probe.get(cv::CAP_PROP_FRAME_COUNT);
+            total = count >= 1 ? static_cast<size_t>(count) : 0;
+        }
+        if (options.max_frames > 0)
+            total = (total > 0) ? std::min(total, options.max_frames) : options.max_frames;
+
+        // Последняя часть идёт до конца видео: CAP_PROP_FRAME_COUNT бывает оценкой.
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunks = (total > 0) ? std::max<size_t>(1, std::min({options.chunks, total, cores})) : 1;
+        std::vector<chunk> parts(chunks);
+        for (size_t i = 0; i < chunks; i++) {
+            parts[i].begin = total * i / chunks;
+            parts[i].end = total * (i + 1) / chunks;
+        }
+        if (options.max_frames == 0)
+            parts.back().end = SIZE_MAX;
+
+        std::vector<std::thread> workers;
+        for (auto &part : parts)
+            workers.emplace_back(run_chunk, std::cref(init), format, options.warmup, std::ref(part));
+
+        bool ok = true;
+        stats = offline_stats{};
+        stats.chunks = chunks;
+        for (auto &part : parts) {
+            while (!part.done.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (!part.error.empty())
+                std::cout << "Ошибка: обработка кадров с " << part.begin << " прервана: " << part.error << std::endl;
+            ok &= part.ok;
+            for (auto &rec : part.records)
+                output(rec);
+            stats.frames += part.records.size();
+            stats.warmup_frames += part.warmup_frames;
+            std::vector<frame_record>().swap(part.records);
+        }
+        for (auto &t : workers)
+            t.join();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return ok;
+    }
+
+}
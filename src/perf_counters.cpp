@@ -0,0 +1,105 @@
+#include "../include/Ransac.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RansacNamespace {
+
+
+    perf_counters::~perf_counters() {
+        for (int fd : fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+/**
+ * Открывает группу счётчиков для вызывающего потока. Лидер группы - счётчик тактов,
+ * остальные счётчики добавляются, если ядро их поддерживает.
+ *
+ * @return true, если открыт хотя бы счётчик тактов.
+ */
+    bool perf_counters::open() {
+        if (tried)
+            return is_open();
+        tried = true;
+
+        static const uint64_t configs[perf_event_count] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (size_t i = 0; i < perf_event_count; i++) {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.disabled = (i == 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            int group = (i == 0) ? -1 : fds[0];
+            long fd = syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+            if (fd < 0) {
+                if (i == 0) {
+                    if ((errno == EACCES) || (errno == EPERM))
+                        last_error = "нет прав (kernel.perf_event_paranoid)";
+                    else if ((errno == ENOENT) || (errno == ENODEV) || (errno == EOPNOTSUPP))
+                        last_error = "счётчики не поддерживаются процессором или гипервизором";
+                    else
+                        last_error = std::strerror(errno);
+                    return false;
+                }
+                continue; // Счётчик не поддерживается, остальные работают.
+            }
+            fds[i] = static_cast<int>(fd);
+            slots[i] = opened++;
+        }
+
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+
+    bool perf_counters::is_open() const {
+        return fds[0] >= 0;
+    }
+
+    bool perf_counters::supported(perf_event_kind kind) const {
+        return fds[static_cast<size_t>(kind)] >= 0;
+    }
+
+    const std::string& perf_counters::error() const {
+        return last_error;
+    }
+
+/**
+ * Читает всю группу одним системным вызовом.
+ *
+ * @param values - значения счётчиков в порядке perf_event_kind.
+ * @return false, если счётчики не открыты или чтение не удалось.
+ */
+    bool perf_counters::read(perf_values& values) const {
+        if (!is_open())
+            return false;
+        uint64_t buffer[1 + perf_event_count];
+        ssize_t n = ::read(fds[0], buffer, sizeof(buffer));
+        if ((n < static_cast<ssize_t>(sizeof(uint64_t))) || (buffer[0] != opened))
+            return false;
+        for (size_t i = 0; i < perf_event_count; i++)
+            values[i] = (fds[i] >= 0) ? buffer[1 + slots[i]] : 0;
+        return true;
+    }
+
+    perf_counters& perf_counters::this_thread() {
+        thread_local perf_counters counters;
+        counters.open();
+        return counters;
+    }
+
+}
@@ -0,0 +1,158 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+    lane_pipeline::lane_pipeline(LaneDetector& lane_detector, frame_source& frames, size_t depth)
+            : detector(lane_detector), source(frames), slots(std::max<size_t>(depth, 3)),
+              free_slots(slots.size()), decoded(slots.size()), prepared(slots.size()), done(slots.size()),
+              started(std::chrono::steady_clock::now()) {
+        // Все ячейки свободны. Очереди рассчитаны на все ячейки сразу, push не может не пройти.
+        for (size_t i = 0; i < slots.size(); i++)
+            free_slots.push(i);
+        decoder = std::thread(&lane_pipeline::decode_loop, this);
+        front_worker = std::thread(&lane_pipeline::front_loop, this);
+        back_worker = std::thread(&lane_pipeline::back_loop, this);
+    }
+
+    lane_pipeline::~lane_pipeline() {
+        stop();
+    }
+
+    void lane_pipeline::stop() {
+        running.store(false, std::memory_order_release);
+        for (wait_signal *signal : {&free_ready, &decoded_ready, &prepared_ready, &done_ready})
+            signal->notify();
+        for (std::thread *t : {&decoder, &front_worker, &back_worker}) {
+            if (t->joinable())
+                t->join();
+        }
+        for (auto &s : slots) {
+            s.frame.release();
+            release_frame(s.input);
+        }
+    }
+
+/**
+ * Ждёт элемент очереди: поток спит до push() в очередь, завершения предыдущего этапа или остановки.
+ *
+ * @param queue - очередь.
+ * @param signal - сигнал, который подаётся после push() в очередь и после флага upstream_finished.
+ * @param item - извлечённый элемент.
+ * @param upstream_finished - флаг завершения предыдущего этапа (nullptr - этап не завершается).
+ * @return false, если конвейер остановлен или предыдущий этап завершён и очередь пуста.
+ */
+    bool lane_pipeline::wait_pop(spsc_queue<size_t>& queue, wait_signal& signal, size_t& item,
+                                 const std::atomic<bool>* upstream_finished) {
+        auto finished = [upstream_finished]() {
+            return (upstream_finished != nullptr) && upstream_finished->load(std::memory_order_acquire);
+        };
+        while (running.load(std::memory_order_acquire)) {
+            if (queue.pop(item))
+                return true;
+            // Флаг ставится после последнего push, поэтому очередь проверяется ещё раз.
+            if (finished())
+                return queue.pop(item);
+            signal.wait([&]() { return !queue.empty() || finished() || !running.load(std::memory_order_acquire); });
+        }
+        return false;
+    }
+
+    void lane_pipeline::decode_loop() {
+        trace::set_thread_name("decode");
+        size_t i;
+        while (wait_pop(free_slots, free_ready, i, nullptr)) {
+            slot &s = slots[i];
+            s.start = std::chrono::steady_clock::now();
+            bool ok;
+            {
+                trace_scope read_scope("read");
+                LANE_STAGE_SCOPE(timer, detector.profiler(), capture);
+                ok = source.next(s.input);
+            }
+            if (ok && !wrap_frame(s.input, s.frame)) {
+                release_frame(s.input);
+                ok = false;
+            }
+            if (!ok)
+                break;
+            s.capture_ns = (s.input.timestamp_ns != 0) ? s.input.timestamp_ns : lane_shm_now_ns();
+            decoded.push(i);
+            decoded_ready.notify();
+        }
+        decode_finished.store(true, std::memory_order_release);
+        decoded_ready.notify();
+    }
+
+    void lane_pipeline::front_loop() {
+        trace::set_thread_name("front_end");
+        size_t i;
+        while (wait_pop(decoded, decoded_ready, i, &decode_finished)) {
+            auto begin = std::chrono::steady_clock::now();
+            detector.front_end(slots[i].frame, slots[i].front);
+            slots[i].processing = std::chrono::steady_clock::now() - begin;
+            prepared.push(i);
+            prepared_ready.notify();
+        }
+        front_finished.store(true, std::memory_order_release);
+        prepared_ready.notify();
+    }
+
+    void lane_pipeline::back_loop() {
+        trace::set_thread_name("back_end");
+        size_t i;
+        while (wait_pop(prepared, prepared_ready, i, &front_finished)) {
+            slot &s = slots[i];
+            auto begin = std::chrono::steady_clock::now();
+            detector.back_end(s.front, s.result);
+            auto now = std::chrono::steady_clock::now();
+            s.processing += now - begin;
+            frame_latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - s.start).count()));
+            last_done_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count(),
+                               std::memory_order_relaxed);
+            done.push(i);
+            done_ready.notify();
+        }
+        back_finished.store(true, std::memory_order_release);
+        done_ready.notify();
+    }
+
+    lane_pipeline::slot* lane_pipeline::next() {
+        size_t i;
+        if (!wait_pop(done, done_ready, i, &back_finished))
+            return nullptr;
+        return &slots[i];
+    }
+
+    void lane_pipeline::release(slot* s) {
+        s->frame.release();
+        release_frame(s->input);
+        free_slots.push(static_cast<size_t>(s - slots.data()));
+        free_ready.notify();
+    }
+
+    const latency_histogram& lane_pipeline::latency() const {
+        return frame_latency;
+    }
+
+/**
+ * Выводит количество кадров, кадры в секунду и квантили задержки кадра.
+ * Без конвейера кадры в секунду ограничены суммой времени этапов, с конвейером - самым медленным этапом.
+ */
+    void lane_pipeline::report(std::ostream& out) const {
+        auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+        uint64_t frames = frame_latency.count();
+        double seconds = static_cast<double>(last_done_ns.load(std::memory_order_relaxed)) / 1e9;
+        out << "\nКонвейер (" << slots.size() << " кадров в обработке): " << frames << " кадров, "
+            << std::fixed << std::setprecision(1) << (seconds > 0 ? static_cast<double>(frames) / seconds : 0.0)
+            << " кадров/с\n";
+        if (frames > 0) {
+            out << std::setprecision(3) << "Задержка кадра, мс: p50 " << ms(frame_latency.quantile(0.50))
+                << ", p90 " << ms(frame_latency.quantile(0.90)) << ", p99 " << ms(frame_latency.quantile(0.99))
+                << ", max " << ms(frame_latency.max()) << "\n";
+        }
+        out << std::defaultfloat << std::flush;
+    }
+
+}
@@ -0,0 +1,140 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * Матрица bird преобразования в изображение сверху, уменьшенное в scale раз.
+ *
+ * @param M - матрица преобразования в полное изображение сверху (CV_64F, 3x3).
+ * @param scale - масштаб (0..1].
+ * @return diag(scale, scale, 1) * M.
+ */
+    cv::Mat pyramid_matrix(const cv::Mat& M, double scale) {
+        cv::Mat scaled = M.clone();
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 3; j++)
+                scaled.at<double>(i, j) *= scale;
+        return scaled;
+    }
+
+/**
+ * Матрица bird преобразования плоскости цветности YUV 4:2:0 (половинное разрешение кадра и результата).
+ *
+ * @param M - матрица преобразования яркости (CV_64F, 3x3).
+ * @return diag(1/2, 1/2, 1) * M * diag(2, 2, 1).
+ */
+    cv::Mat chroma_matrix(const cv::Mat& M) {
+        cv::Mat half = pyramid_matrix(M, 0.5);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 2; j++)
+                half.at<double>(i, j) *= 2;
+        return half;
+    }
+
+
+    namespace {
+
+        /**
+         * Добавляет полосу столбцов вокруг линии. Линия задана в изображении, уменьшенном в scale раз:
+         * в полном изображении её коэффициенты {a*scale, b, c/scale}.
+         */
+        void add_band(const LanePoly& line, double scale, int margin, cv::Size full_size, std::vector<cv::Range>& bands) {
+            double a = static_cast<double>(line.a) * scale;
+            double b = line.b;
+            double c = line.c / scale;
+            double h = full_size.height;
+            // Крайние столбцы - на краях изображения или в вершине параболы.
+            double lo = std::min(c, (a * h + b) * h + c);
+            double hi = std::max(c, (a * h + b) * h + c);
+            if (std::abs(a) > 1e-12) {
+                double vertex = -b / (2 * a);
+                if ((vertex > 0) && (vertex < h)) {
+                    double x = (a * vertex + b) * vertex + c;
+                    lo = std::min(lo, x);
+                    hi = std::max(hi, x);
+                }
+            }
+            int start = std::max(0, static_cast<int>(std::floor(lo)) - margin);
+            int end = std::min(full_size.width, static_cast<int>(std::ceil(hi)) + margin);
+            if (start < end)
+                bands.emplace_back(start, end);
+        }
+
+        /// Сортирует полосы и объединяет пересекающиеся.
+        void merge_bands(std::vector<cv::Range>& bands) {
+            std::sort(bands.begin(), bands.end(), [](const cv::Range& l, const cv::Range& r) { return l.start < r.start; });
+            size_t merged = 0;
+            for (size_t i = 0; i < bands.size(); i++) {
+                if ((merged > 0) && (bands[i].start <= bands[merged - 1].end))
+                    bands[merged - 1].end = std::max(bands[merged - 1].end, bands[i].end);
+                else
+                    bands[merged++] = bands[i];
+            }
+            bands.resize(merged, cv::Range(0, 0));
+        }
+    }
+
+/**
+ * Полосы столбцов полного изображения сверху вокруг линий, найденных грубым поиском.
+ * Пересекающиеся полосы объединяются.
+ *
+ * @param coarse_lines - прямые в координатах уменьшенного изображения (нулевые пропускаются).
+ * @param scale - масштаб уменьшенного изображения.
+ * @param margin - отступ от линии в каждую сторону, пиксели полного изображения.
+ * @param full_size - размер полного изображения сверху.
+ * @param bands - диапазоны столбцов [start, end), отсортированные по start.
+ */
+    void pyramid_bands(const std::vector<LanePoly>& coarse_lines, double scale, int margin, cv::Size full_size,
+                       std::vector<cv::Range>& bands) {
+        bands.clear();
+        for (auto &line : coarse_lines) {
+            if (line.found())
+                add_band(line, scale, margin, full_size, bands);
+        }
+        merge_bands(bands);
+    }
+
+/**
+ * Полосы столбцов вокруг линий предыдущих кадров (полиномы в полном изображении сверху).
+ *
+ * @param lines - линии по полосам (ненайденные пропускаются).
+ * @param margin - отступ от линии в каждую сторону.
+ * @param full_size - размер изображения сверху.
+ * @param bands - диапазоны столбцов [start, end), отсортированные по start.
+ */
+    void track_bands(const lane_polys& lines, int margin, cv::Size full_size, std::vector<cv::Range>& bands) {
+        bands.clear();
+        for (auto &line : lines) {
+            if (line.found())
+                add_band(line, 1.0, margin, full_size, bands);
+        }
+        merge_bands(bands);
+    }
+
+
+/**
+ * Переводит в перспективу сверху только диапазон столбцов результата.
+ * Матрица сдвигается на начало диапазона, результат пишется прямо в столбцы bird.
+ *
+ * @param frame - кадр камеры.
+ * @param M - матрица преобразования в полное изображение сверху (CV_64F, 3x3).
+ * @param cols - диапазон столбцов изображения сверху.
+ * @param bird - изображение сверху (уже создано с нужным размером и типом).
+ * @param border - значение пикселей за пределами кадра.
+ */
+    void warp_band(const cv::Mat& frame, const cv::Mat& M, const cv::Range& cols, cv::Mat& bird, const cv::Scalar& border) {
+        // T(-start, 0) * M: из первой строки вычитается третья, умноженная на start.
+        double shifted[9];
+        const double *m = M.ptr<double>();
+        for (size_t j = 0; j < 3; j++) {
+            shifted[j] = m[j] - cols.start * m[6 + j];
+            shifted[3 + j] = m[3 + j];
+            shifted[6 + j] = m[6 + j];
+        }
+        cv::Mat shift_matrix(3, 3, CV_64F, shifted);
+        cv::Mat band = bird.colRange(cols.start, cols.end);
+        cv::warpPerspective(frame, band, shift_matrix, band.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, border);
+    }
+
+}
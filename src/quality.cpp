@@ -0,0 +1,139 @@
+#include "../include/Ransac.h"
+
+#include <sstream>
+
+namespace RansacNamespace {
+
+
+    namespace {
+
+        /// Этапы подготовки изображения: их время уменьшают слежение и грубый поиск в уменьшенном изображении.
+        const stage image_stages[] = {stage::change, stage::coarse, stage::warp, stage::threshold, stage::contours};
+
+        /// Изменённые параметры в виде "имя старое -> новое".
+        std::string describe(const quality_knobs& from, const quality_knobs& to) {
+            std::ostringstream out;
+            auto field = [&out](const char* name, auto a, auto b, bool changed) {
+                if (changed)
+                    out << (out.tellp() > 0 ? ", " : "") << name << " " << a << " -> " << b;
+            };
+            field("roi_margin", from.roi_margin, to.roi_margin, from.roi_margin != to.roi_margin);
+            field("pyramid_scale", from.pyramid_scale, to.pyramid_scale,
+                  std::abs(from.pyramid_scale - to.pyramid_scale) > 1e-9);
+            field("scan_step", from.scan_step, to.scan_step, from.scan_step != to.scan_step);
+            field("scan_budget", from.scan_budget, to.scan_budget, from.scan_budget != to.scan_budget);
+            return out.str();
+        }
+    }
+
+
+    quality_knobs quality_knobs::from(const settings& config) {
+        quality_knobs knobs;
+        knobs.roi_margin = config.roi_margin;
+        knobs.pyramid_scale = config.pyramid_scale;
+        knobs.scan_step = config.scan_step;
+        knobs.scan_budget = config.scan_budget;
+        return knobs;
+    }
+
+
+    quality_controller::quality_controller(const settings& config)
+            : current(quality_knobs::from(config)), target_seconds(config.target_frame_ms / 1e3),
+              window(config.quality_window), min_scale(config.quality_min_scale),
+              min_budget(config.quality_min_budget), roi_margin(config.quality_roi_margin),
+              scan_step(config.quality_scan_step) {}
+
+    const quality_knobs& quality_controller::knobs() const {
+        return current;
+    }
+
+    size_t quality_controller::level() const {
+        return history.size();
+    }
+
+/**
+ * Среднее время кадра за окно - по сумме таймеров этапов детектора (без чтения кадра и отображения),
+ * если они собраны, иначе по времени, переданному вызывающей стороной. В конвейере этапы идут
+ * в разных потоках, и сумма этапов - оценка сверху.
+ */
+    bool quality_controller::update(double frame_seconds, const stage_profiler& profiler, std::ostream& log) {
+        frame_seconds_sum += frame_seconds;
+        if ((target_seconds <= 0) || (++frames < window))
+            return false;
+
+        uint64_t image_ns = 0, total_ns = 0, ransac_ns = 0;
+        for (size_t i = 0; i < stage_count; i++) {
+            auto s = static_cast<stage>(i);
+            uint64_t sum = profiler.histogram(s).sum();
+            uint64_t delta = sum - stage_sums[i];
+            stage_sums[i] = sum;
+            if ((s == stage::capture) || (s == stage::render))
+                continue;
+            total_ns += delta;
+            if (s == stage::ransac)
+                ransac_ns = delta;
+            if (std::find(std::begin(image_stages), std::end(image_stages), s) != std::end(image_stages))
+                image_ns += delta;
+        }
+        double mean = (total_ns > 0) ? static_cast<double>(total_ns) / 1e9 / frames : frame_seconds_sum / frames;
+        frames = 0;
+        frame_seconds_sum = 0;
+
+        quality_knobs before = current;
+        if (mean > target_seconds) {
+            if (!degrade(image_ns >= ransac_ns))
+                return false;
+        } else if ((mean < 0.75 * target_seconds) && !history.empty()) {
+            current = history.back();
+            history.pop_back();
+        } else {
+            return false;
+        }
+        // Формат задаётся локальному потоку: настройки потока журнала (std::cout) не меняются.
+        std::ostringstream line;
+        line << "Регулятор качества: кадр " << std::fixed << std::setprecision(1) << mean * 1e3 << " мс (цель "
+             << target_seconds * 1e3 << " мс), уровень " << history.size() << ": " << describe(before, current);
+        log << line.str() << std::endl;
+        return true;
+    }
+
+/**
+ * Один шаг снижения качества: сначала в части обработки, занявшей больше времени, затем в другой.
+ *
+ * @return false, если качество уже на нижних границах.
+ */
+    bool quality_controller::degrade(bool image_first) {
+        quality_knobs before = current;
+        bool changed = image_first ? (degrade_image() || degrade_points()) : (degrade_points() || degrade_image());
+        if (changed)
+            history.push_back(before);
+        return changed;
+    }
+
+    /// Слежение за линиями, затем уменьшение масштаба грубого поиска вдвое до quality_min_scale.
+    bool quality_controller::degrade_image() {
+        if (current.roi_margin == 0) {
+            current.roi_margin = roi_margin;
+            return true;
+        }
+        if (current.pyramid_scale > min_scale + 1e-9) {
+            current.pyramid_scale = std::max(min_scale, current.pyramid_scale / 2);
+            return true;
+        }
+        return false;
+    }
+
+    /// Точки по строкам маски (шаг quality_scan_step) вместо точек контуров, затем уменьшение бюджета точек вдвое до quality_min_budget.
+    bool quality_controller::degrade_points() {
+        if (current.scan_step == 0) {
+            current.scan_step = scan_step;
+            return true;
+        }
+        if (current.scan_budget > min_budget) {
+            current.scan_budget = std::max(min_budget, current.scan_budget / 2);
+            return true;
+        }
+        return false;
+    }
+
+}
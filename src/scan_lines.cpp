@@ -0,0 +1,76 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * scan_line_points - точки разметки для RANSAC по строкам маски. В строках каждого отфильтрованного
+ * контура ищутся отрезки разметки шириной [scan_min_width, scan_max_width] внутри самого контура
+ * (по залитой метке контура, а не по описанному прямоугольнику); от отрезка берётся одна точка - его середина.
+ * Граничные точки одного штриха не дублируются, пятна, отброшенные filtered_img(), не учитываются,
+ * поэтому количество точек зависит от длины линий в строках, а не от размера и формы пятен.
+ *
+ * Бюджет делится между контурами пропорционально количеству их строк: если точек при шаге step
+ * получается больше доли контура, шаг строк этого контура увеличивается. Прореживание равномерно
+ * по всем линиям, больше budget точек не выдаётся ни при каком разрешении.
+ *
+ * @param mask - маска изображения сверху.
+ * @param contours - контуры, прошедшие фильтр filtered_img() (обходятся в обратном порядке, как в filtered_coord).
+ * @param step - шаг строк.
+ * @param budget - максимальное количество точек.
+ * @param labels - метки контуров, CV_32SC1 размером маски (промежуточный буфер).
+ * @param points - середины отрезков (строка, столбец).
+ */
+    void scan_line_points(const cv::Mat& mask, const std::vector<std::vector<cv::Point>>& contours, int step, size_t budget,
+                          cv::Mat& labels, point_buffer& points) {
+        cv::Rect image(0, 0, mask.cols, mask.rows);
+        labels.create(mask.size(), CV_32SC1);
+        size_t rows = 0;
+        for (auto &cnt : contours) {
+            cv::Rect rect = cv::boundingRect(cnt) & image;
+            labels(rect).setTo(cv::Scalar::all(0));
+            rows += static_cast<size_t>(rect.height);
+        }
+        // Метка - номер контура + 1. Пиксель принадлежит одному контуру, отрезки не повторяются.
+        for (size_t i = 0; i < contours.size(); i++)
+            cv::drawContours(labels, contours, static_cast<int>(i), cv::Scalar::all(static_cast<double>(i + 1)), cv::FILLED);
+
+        points.rows.resize(budget);
+        points.cols.resize(budget);
+        size_t n = 0, rows_before = 0;
+        for (size_t i = contours.size(); i-- > 0;) {
+            cv::Rect rect = cv::boundingRect(contours[i]) & image;
+            size_t height = static_cast<size_t>(rect.height);
+            // Доля бюджета по накопленным строкам: сумма долей равна budget без потерь на округлении.
+            size_t share = (rows > 0) ? (budget * (rows_before + height) / rows - budget * rows_before / rows) : 0;
+            rows_before += height;
+            if (share == 0)
+                continue;
+            size_t stride = std::max(static_cast<size_t>(std::max(step, 1)), (height + share - 1) / share);
+            size_t limit = n + share;
+            auto label = static_cast<int>(i + 1);
+
+            for (int r = rect.y; (r < rect.y + rect.height) && (n < limit); r += static_cast<int>(stride)) {
+                const uint8_t *m = mask.ptr<uint8_t>(r);
+                const int *l = labels.ptr<int>(r);
+                for (int c = rect.x; (c < rect.x + rect.width) && (n < limit);) {
+                    if ((m[c] == 0) || (l[c] != label)) {
+                        c++;
+                        continue;
+                    }
+                    int start = c;
+                    while ((c < rect.x + rect.width) && (m[c] != 0) && (l[c] == label))
+                        c++;
+                    int width = c - start;
+                    if ((width < scan_min_width) || (width > scan_max_width))
+                        continue;
+                    points.rows[n] = static_cast<float>(r);
+                    points.cols[n++] = 0.5f * static_cast<float>(start + c - 1);
+                }
+            }
+        }
+        points.rows.resize(n);
+        points.cols.resize(n);
+    }
+
+}
@@ -9,8 +9,10 @@ namespace RansacNamespace{
     settings::settings() {
 
         video_name = "../data/polos.mp4"; // video_name <-  Путь до видео фрагмента
+        input_format = "bgr"; // <- Формат кадров: "bgr", "nv12" или "i420"
 
         sens_for_type = 200; // <- Значение чувствительности к белым пикселям. Чем больше значение, тем больше вероятность обнаружить прерывистую линию.
+        solid_duty = 0.75; // <- Минимальная доля строк с разметкой вдоль линии для сплошной линии
         fontSize = 1;  //  <- параметры шрифта
         thickness = 2; // <- параметры шрифта
         min_inliers = 20; //  <-  Минимальное количество точек, необходимое для определения линии. Для функции Ransac
@@ -21,11 +23,39 @@ namespace RansacNamespace{
         cout_stripes = 4; // <- Максимальное количество детектируемых линий
         cout_containers = 10; // <- Размер контейнера для учёта предыдущих итераций детекции
 
+        telemetry_format = "jsonl"; // <- Формат телеметрии: "jsonl", "csv" или "bin"
+        telemetry_path = ""; // <- Файл для записи телеметрии (пустая строка - stdout)
+        telemetry_rate_hz = 0; // <- Максимальная частота записей телеметрии, Гц (0 - без ограничения)
+        telemetry_queue_size = 256; // <- Размер очереди телеметрии
+
+        shm_name = ""; // <- Имя сегмента разделяемой памяти для результатов, например "/lanes" (пустая строка - не публиковать)
+        shm_capacity = 64; // <- Количество слотов в кольце разделяемой памяти
+
+        pyramid_scale = 1; // <- Масштаб грубого поиска линий, например 0.5 (1 - поиск в полном разрешении)
+        pyramid_margin = 30; // <- Половина ширины полосы уточнения вокруг найденной линии
+        roi_margin = 0; // <- Половина ширины полосы поиска вокруг линий предыдущего кадра (0 - поиск по всему изображению)
+        roi_reacquire_interval = 30; // <- Каждый такой кадр обрабатывается целиком для поиска новых линий (0 - только при потере линий)
+        sparse_front = 0; // <- 1 - фильтр в кадре камеры и проекция только пятен разметки (без bird преобразования кадра)
+        static_threshold = 0; // <- Разница яркости клетки трапеции, ниже которой сцена считается неизменной (0 - выключено)
+        static_max_reuse = 10; // <- Не больше стольких кадров подряд повторяют предыдущий результат
+        scan_step = 0; // <- Каждая такая строка маски даёт RANSAC по одной точке на отрезок разметки (0 - точки контуров)
+        scan_budget = 1000; // <- Не больше стольких точек на кадр
+        target_frame_ms = 0; // <- Время кадра, которое держит регулятор качества (0 - качество не меняется)
+        quality_window = 30; // <- Регулятор принимает решение раз в столько кадров
+        quality_min_scale = 0.25; // <- Наименьший масштаб грубого поиска
+        quality_min_budget = 200; // <- Наименьший бюджет точек RANSAC
+        quality_roi_margin = 30; // <- Полоса слежения, которую включает регулятор, если roi_margin = 0
+        quality_scan_step = 2; // <- Шаг строк, с которым регулятор включает точки по строкам, если scan_step = 0
+        metrics_port = 0; // <- Порт метрик Prometheus на 127.0.0.1, например 9464 (0 - выключено)
+
         // параметры для milcam
 
         parametersBird = {381, 350, 557, 350,  0, 531, 906, 533, 608, 371}; // параметры для milcam
         parametersHSV = { 21, 76, 13, 48, 110, 28};
 
+        w1920_to_width = 1.0;
+        h1080_to_height = 1.0;
+
         transformationMatrix << -9.8317563130660944e-03, -3.0483869954955277e-03, 2.7366480699891205e+00,
                                 2.9370686204037151e-03, -4.6695660667826495e-02, 1.8811209772606649e+01,
                                 1.6456794776922032e-03, -7.1019174142738246e-03, 1.0; // параметры калибровки
@@ -54,4 +84,244 @@ namespace RansacNamespace{
         return vec_container_stripes; // Возвращаем вектор интервалов ширины полос.
     }
 
-}
\ No newline at end of file
+
+
+/**
+ * Чтение целого значения из конфигурации с проверкой диапазона.
+ *
+ * @return false, если ключ присутствует, но значение вне диапазона [min, max].
+ */
+    static bool read_int(const cv::FileNode& root, const char* key, int& value, int min, int max) {
+        cv::FileNode node = root[key];
+        if (node.empty())
+            return true;
+        int v = static_cast<int>(node);
+        if ((v < min) || (v > max)) {
+            std::cout << "Ошибка конфигурации: " << key << " = " << v << " вне диапазона [" << min << ", " << max << "]" << std::endl;
+            return false;
+        }
+        value = v;
+        return true;
+    }
+
+    static bool read_size(const cv::FileNode& root, const char* key, size_t& value, int min, int max) {
+        int v = static_cast<int>(value);
+        if (!read_int(root, key, v, min, max))
+            return false;
+        value = static_cast<size_t>(v);
+        return true;
+    }
+
+    static bool read_double(const cv::FileNode& root, const char* key, double& value, double min, double max) {
+        cv::FileNode node = root[key];
+        if (node.empty())
+            return true;
+        double v = static_cast<double>(node);
+        if (!(v >= min) || !(v <= max)) {
+            std::cout << "Ошибка конфигурации: " << key << " = " << v << " вне диапазона [" << min << ", " << max << "]" << std::endl;
+            return false;
+        }
+        value = v;
+        return true;
+    }
+
+    static bool read_vector(const cv::FileNode& root, const char* key, std::vector<int>& value, size_t size) {
+        cv::FileNode node = root[key];
+        if (node.empty())
+            return true;
+        std::vector<int> v;
+        node >> v;
+        if (v.size() != size) {
+            std::cout << "Ошибка конфигурации: " << key << " должен содержать " << size << " значений" << std::endl;
+            return false;
+        }
+        value = v;
+        return true;
+    }
+
+    static void read_string(const cv::FileNode& root, const char* key, std::string& value) {
+        cv::FileNode node = root[key];
+        if (!node.empty())
+            value = static_cast<std::string>(node);
+    }
+
+
+/**
+ * load - загружает параметры детекции из одного файла конфигурации.
+ * Файл содержит все поля settings, параметры bird и HSV преобразований и матрицу калибровки.
+ * Ключи, отсутствующие в файле, сохраняют значения по умолчанию.
+ *
+ * @param path - путь к файлу (YAML или XML в формате cv::FileStorage).
+ * @return true, если файл прочитан и все значения допустимы.
+ */
+    bool settings::load(const std::string& path) {
+        cv::FileStorage fs;
+        if (!fs.open(path, cv::FileStorage::READ)) {
+            std::cout << "Ошибка: не удалось открыть файл конфигурации " << path << std::endl;
+            return false;
+        }
+        cv::FileNode root = fs.root();
+        bool ok = true;
+
+        read_string(root, "video_name", video_name);
+        read_string(root, "input_format", input_format);
+        ok &= read_int(root, "sens_for_type", sens_for_type, 0, 255);
+        ok &= read_double(root, "solid_duty", solid_duty, 0, 1);
+        ok &= read_int(root, "fontSize", fontSize, 0, 100);
+        ok &= read_int(root, "thickness", thickness, 0, 100);
+        ok &= read_int(root, "width_line_search", width_line_search, 1, 10000);
+        ok &= read_double(root, "Dist_threshold", Dist_threshold, 0, 10000);
+        ok &= read_int(root, "sense_to_normolize_data", sense_to_normolize_data, 0, 10000);
+        ok &= read_size(root, "cout_stripes", cout_stripes, 1, static_cast<int>(telemetry_max_stripes));
+        ok &= read_size(root, "min_inliers", min_inliers, 2, 1000000);
+        ok &= read_size(root, "cout_containers", cout_containers, 2, 1000);
+        ok &= read_vector(root, "parametersBird", parametersBird, 10);
+        ok &= read_vector(root, "parametersHSV", parametersHSV, 6);
+        ok &= read_double(root, "w1920_to_width", w1920_to_width, 0, 100);
+        ok &= read_double(root, "h1080_to_height", h1080_to_height, 0, 100);
+
+        cv::FileNode matrix_node = root["transformationMatrix"];
+        if (!matrix_node.empty()) {
+            cv::Mat matrix;
+            matrix_node >> matrix;
+            if ((matrix.rows != 3) || (matrix.cols != 3)) {
+                std::cout << "Ошибка конфигурации: transformationMatrix должна быть 3x3" << std::endl;
+                ok = false;
+            } else {
+                matrix.convertTo(matrix, CV_64F);
+                for (int i = 0; i < 3; i++)
+                    for (int j = 0; j < 3; j++)
+                        transformationMatrix(i, j) = matrix.at<double>(i, j);
+            }
+        }
+
+        read_string(root, "telemetry_format", telemetry_format);
+        read_string(root, "telemetry_path", telemetry_path);
+        ok &= read_double(root, "telemetry_rate_hz", telemetry_rate_hz, 0, 1e6);
+        ok &= read_size(root, "telemetry_queue_size", telemetry_queue_size, 1, 1 << 20);
+        read_string(root, "shm_name", shm_name);
+        size_t capacity = shm_capacity;
+        ok &= read_size(root, "shm_capacity", capacity, 1, 1 << 16);
+        shm_capacity = static_cast<uint32_t>(capacity);
+        ok &= read_double(root, "pyramid_scale", pyramid_scale, 0.05, 1);
+        ok &= read_int(root, "pyramid_margin", pyramid_margin, 1, 10000);
+        ok &= read_int(root, "roi_margin", roi_margin, 0, 10000);
+        ok &= read_int(root, "roi_reacquire_interval", roi_reacquire_interval, 0, 1000000);
+        ok &= read_int(root, "sparse_front", sparse_front, 0, 1);
+        ok &= read_double(root, "static_threshold", static_threshold, 0, 255);
+        ok &= read_int(root, "static_max_reuse", static_max_reuse, 0, 1000000);
+        ok &= read_int(root, "scan_step", scan_step, 0, 1000);
+        ok &= read_size(root, "scan_budget", scan_budget, 2, 1000000);
+        ok &= read_double(root, "target_frame_ms", target_frame_ms, 0, 1e6);
+        ok &= read_int(root, "quality_window", quality_window, 1, 1000000);
+        ok &= read_double(root, "quality_min_scale", quality_min_scale, 0.05, 1);
+        ok &= read_size(root, "quality_min_budget", quality_min_budget, 2, 1000000);
+        ok &= read_int(root, "quality_roi_margin", quality_roi_margin, 1, 10000);
+        ok &= read_int(root, "quality_scan_step", quality_scan_step, 1, 1000);
+        ok &= read_int(root, "metrics_port", metrics_port, 0, 65535);
+
+        return ok && validate();
+    }
+
+
+/**
+ * validate - проверяет согласованность параметров, которые нельзя проверить по отдельности.
+ *
+ * @return true, если параметры допустимы.
+ */
+    bool settings::validate() const {
+        bool ok = true;
+        if (parametersBird.size() != 10 || parametersBird[8] <= 0 || parametersBird[9] <= 0) {
+            std::cout << "Ошибка конфигурации: parametersBird - 8 координат и положительные высота и ширина" << std::endl;
+            ok = false;
+        }
+        if (parametersHSV.size() != 6) {
+            std::cout << "Ошибка конфигурации: parametersHSV должен содержать 6 значений" << std::endl;
+            ok = false;
+        } else {
+            for (size_t i = 0; i < 3; i++) {
+                if (parametersHSV[i] > parametersHSV[i + 3] || parametersHSV[i] < 0 || parametersHSV[i + 3] > 255) {
+                    std::cout << "Ошибка конфигурации: parametersHSV - минимум больше максимума или вне [0, 255]" << std::endl;
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if (!telemetry_encoder::create(telemetry_format)) {
+            std::cout << "Ошибка конфигурации: неизвестный формат телеметрии " << telemetry_format << std::endl;
+            ok = false;
+        }
+        frame_format format;
+        if (!parse_frame_format(input_format, format)) {
+            std::cout << "Ошибка конфигурации: неизвестный формат кадров " << input_format << std::endl;
+            ok = false;
+        }
+        if (video_name.empty()) {
+            std::cout << "Ошибка конфигурации: не задан video_name" << std::endl;
+            ok = false;
+        }
+        return ok;
+    }
+
+
+/**
+ * save - сохраняет все параметры в файл конфигурации (формат определяется расширением).
+ *
+ * @param path - путь к файлу.
+ * @return true, если файл записан.
+ */
+    bool settings::save(const std::string& path) const {
+        cv::FileStorage fs;
+        if (!fs.open(path, cv::FileStorage::WRITE)) {
+            std::cout << "Ошибка: не удалось записать файл конфигурации " << path << std::endl;
+            return false;
+        }
+        cv::Mat matrix(3, 3, CV_64F);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                matrix.at<double>(i, j) = transformationMatrix(i, j);
+
+        fs << "video_name" << video_name;
+        fs << "input_format" << input_format;
+        fs << "sens_for_type" << sens_for_type;
+        fs << "solid_duty" << solid_duty;
+        fs << "fontSize" << fontSize;
+        fs << "thickness" << thickness;
+        fs << "width_line_search" << width_line_search;
+        fs << "Dist_threshold" << Dist_threshold;
+        fs << "sense_to_normolize_data" << sense_to_normolize_data;
+        fs << "cout_stripes" << static_cast<int>(cout_stripes);
+        fs << "min_inliers" << static_cast<int>(min_inliers);
+        fs << "cout_containers" << static_cast<int>(cout_containers);
+        fs << "parametersBird" << parametersBird;
+        fs << "parametersHSV" << parametersHSV;
+        fs << "w1920_to_width" << w1920_to_width;
+        fs << "h1080_to_height" << h1080_to_height;
+        fs << "transformationMatrix" << matrix;
+        fs << "telemetry_format" << telemetry_format;
+        fs << "telemetry_path" << telemetry_path;
+        fs << "telemetry_rate_hz" << telemetry_rate_hz;
+        fs << "telemetry_queue_size" << static_cast<int>(telemetry_queue_size);
+        fs << "shm_name" << shm_name;
+        fs << "shm_capacity" << static_cast<int>(shm_capacity);
+        fs << "pyramid_scale" << pyramid_scale;
+        fs << "pyramid_margin" << pyramid_margin;
+        fs << "roi_margin" << roi_margin;
+        fs << "roi_reacquire_interval" << roi_reacquire_interval;
+        fs << "sparse_front" << sparse_front;
+        fs << "static_threshold" << static_threshold;
+        fs << "static_max_reuse" << static_max_reuse;
+        fs << "scan_step" << scan_step;
+        fs << "scan_budget" << static_cast<int>(scan_budget);
+        fs << "target_frame_ms" << target_frame_ms;
+        fs << "quality_window" << quality_window;
+        fs << "quality_min_scale" << quality_min_scale;
+        fs << "quality_min_budget" << static_cast<int>(quality_min_budget);
+        fs << "quality_roi_margin" << quality_roi_margin;
+        fs << "quality_scan_step" << quality_scan_step;
+        fs << "metrics_port" << metrics_port;
+        fs.release();
+        return true;
+    }
+
+}
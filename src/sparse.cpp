@@ -0,0 +1,220 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+    namespace {
+
+        /// Проекция точки кадра в изображение сверху.
+        cv::Point2d project(const double* m, double x, double y) {
+            double w = m[6] * x + m[7] * y + m[8];
+            return {(m[0] * x + m[1] * y + m[2]) / w, (m[3] * x + m[4] * y + m[5]) / w};
+        }
+
+        /// Точка изображения сверху с ограничением по его границам.
+        cv::Point to_bird(const cv::Point2d& p, cv::Size size) {
+            return {std::min(std::max(static_cast<int>(std::lround(p.x)), 0), size.width - 1),
+                    std::min(std::max(static_cast<int>(std::lround(p.y)), 0), size.height - 1)};
+        }
+
+        int find_root(std::vector<int>& parent, int i) {
+            while (parent[static_cast<size_t>(i)] != i) {
+                parent[static_cast<size_t>(i)] = parent[static_cast<size_t>(parent[static_cast<size_t>(i)])];
+                i = parent[static_cast<size_t>(i)];
+            }
+            return i;
+        }
+
+        /// Отрезки строки маски (ненулевые пиксели) со сдвигом offset.
+        void append_runs(const uint8_t* mask, int cols, int row, int offset, std::vector<sparse_buffers::run>& runs) {
+            for (int c = 0; c < cols;) {
+                if (mask[c] == 0) {
+                    c++;
+                    continue;
+                }
+                int start = c;
+                while ((c < cols) && (mask[c] != 0))
+                    c++;
+                runs.push_back({row, start + offset, c + offset});
+            }
+        }
+    }
+
+/**
+ * sparse_spans - отрезки строк кадра внутри трапеции parametersBird (точки 1-4).
+ * Для каждой строки берутся крайние пересечения с четырьмя сторонами.
+ *
+ * @param parametersBird - параметры bird преобразования.
+ * @param buffers - результат: top и spans.
+ */
+    void sparse_spans(const std::vector<int>& parametersBird, sparse_buffers& buffers) {
+        // Обход по контуру: верхний левый, верхний правый, нижний правый, нижний левый.
+        cv::Point2d quad[4] = {{static_cast<double>(parametersBird[0]), static_cast<double>(parametersBird[1])},
+                               {static_cast<double>(parametersBird[2]), static_cast<double>(parametersBird[3])},
+                               {static_cast<double>(parametersBird[6]), static_cast<double>(parametersBird[7])},
+                               {static_cast<double>(parametersBird[4]), static_cast<double>(parametersBird[5])}};
+        double top = quad[0].y, bottom = quad[0].y;
+        for (auto &p : quad) {
+            top = std::min(top, p.y);
+            bottom = std::max(bottom, p.y);
+        }
+        buffers.top = static_cast<int>(std::ceil(top));
+        buffers.spans.clear();
+        for (int row = buffers.top; row <= static_cast<int>(std::floor(bottom)); row++) {
+            double lo = 1e9, hi = -1e9;
+            for (size_t i = 0; i < 4; i++) {
+                const cv::Point2d &a = quad[i], &b = quad[(i + 1) % 4];
+                if ((row < std::min(a.y, b.y)) || (row > std::max(a.y, b.y)))
+                    continue;
+                double dy = b.y - a.y;
+                if (std::abs(dy) < 1e-9) {
+                    lo = std::min(lo, std::min(a.x, b.x));
+                    hi = std::max(hi, std::max(a.x, b.x));
+                } else {
+                    double x = a.x + (b.x - a.x) * (row - a.y) / dy;
+                    lo = std::min(lo, x);
+                    hi = std::max(hi, x);
+                }
+            }
+            if (lo <= hi)
+                buffers.spans.emplace_back(static_cast<int>(std::ceil(lo)), static_cast<int>(std::floor(hi)) + 1);
+            else
+                buffers.spans.emplace_back(0, 0);
+        }
+    }
+
+/**
+ * sparse_threshold - цветовой фильтр в кадре камеры только внутри трапеции и выделение отрезков строк.
+ * Кадр BGR фильтруется по строкам через return_hsv(), кадр YUV - по таблице yuv_lut.
+ *
+ * @param frame - кадр BGR или яркость кадра YUV.
+ * @param chroma - цветность кадра YUV (CV_8UC2, половинное разрешение), для BGR не используется.
+ * @param parametersHSV - параметры цветового фильтра.
+ * @param lut - таблица порогов YUV (пустая для BGR).
+ * @param buffers - отрезки трапеции (sparse_spans()) и результат: отрезки разметки по строкам.
+ */
+    void sparse_threshold(const cv::Mat& frame, const cv::Mat& chroma, std::vector<int>& parametersHSV,
+                          const hsv::yuv_lut& lut, sparse_buffers& buffers) {
+        buffers.runs.clear();
+        bool yuv = !lut.table.empty();
+        for (size_t i = 0; i < buffers.spans.size(); i++) {
+            int row = buffers.top + static_cast<int>(i);
+            int start = std::max(0, buffers.spans[i].start);
+            int end = std::min(frame.cols, buffers.spans[i].end);
+            if ((row < 0) || (row >= frame.rows) || (start >= end))
+                continue;
+
+            if (yuv) {
+                buffers.mask_row.create(1, end - start, CV_8UC1);
+                const uint8_t *y = frame.ptr<uint8_t>(row);
+                const uint8_t *uv = chroma.ptr<uint8_t>(row / 2);
+                uint8_t *m = buffers.mask_row.ptr<uint8_t>(0);
+                for (int c = start; c < end; c++) {
+                    size_t k = 2 * static_cast<size_t>(c / 2);
+                    m[c - start] = lut(y[c], uv[k], uv[k + 1]);
+                }
+            } else {
+                hsv::return_hsv(frame.row(row).colRange(start, end), parametersHSV, buffers.hls_row, buffers.mask_row);
+            }
+            append_runs(buffers.mask_row.ptr<uint8_t>(0), end - start, row, start, buffers.runs);
+        }
+    }
+
+/**
+ * sparse_blobs - объединение отрезков в пятна (8-связность), проекция пятен в изображение сверху
+ * и фильтрация теми же условиями, что в filtered_img(). Контур пятна - проекция концов его отрезков
+ * в порядке обхода внешних контуров findContours (вниз по левому краю, вверх по правому).
+ *
+ * @param M - матрица bird преобразования (CV_64F, 3x3).
+ * @param bird_size - размер изображения сверху.
+ * @param buffers - отрезки (sparse_threshold()) и промежуточные данные.
+ * @param filtered_contours - контуры прошедших фильтр пятен в координатах изображения сверху.
+ * @param filtered_coord - точки этих контуров.
+ * @param mask - маска изображения сверху: проекции отрезков прошедших фильтр пятен.
+ */
+    void sparse_blobs(const cv::Mat& M, cv::Size bird_size, sparse_buffers& buffers,
+                      std::vector<std::vector<cv::Point>>& filtered_contours, point_buffer& filtered_coord, cv::Mat& mask) {
+        const double *m = M.ptr<double>();
+        std::vector<sparse_buffers::run> &runs = buffers.runs;
+        std::vector<int> &parent = buffers.parent;
+        parent.resize(runs.size());
+        for (size_t i = 0; i < runs.size(); i++)
+            parent[i] = static_cast<int>(i);
+
+        // Отрезки идут по строкам: соседние строки сравниваются двумя указателями.
+        size_t prev_begin = 0, prev_end = 0;
+        for (size_t i = 0; i < runs.size();) {
+            size_t row_end = i;
+            while ((row_end < runs.size()) && (runs[row_end].row == runs[i].row))
+                row_end++;
+            if ((prev_end > prev_begin) && (runs[prev_begin].row + 1 == runs[i].row)) {
+                size_t p = prev_begin;
+                for (size_t c = i; c < row_end; c++) {
+                    while ((p < prev_end) && (runs[p].end < runs[c].start))
+                        p++;
+                    for (size_t q = p; (q < prev_end) && (runs[q].start <= runs[c].end); q++) {
+                        int a = find_root(parent, static_cast<int>(c)), b = find_root(parent, static_cast<int>(q));
+                        if (a != b)
+                            parent[static_cast<size_t>(std::max(a, b))] = std::min(a, b);
+                    }
+                }
+            }
+            prev_begin = i;
+            prev_end = row_end;
+            i = row_end;
+        }
+
+        // Отрезки каждого пятна подряд, внутри пятна - по строкам.
+        buffers.order.resize(runs.size());
+        for (size_t i = 0; i < runs.size(); i++)
+            buffers.order[i] = {find_root(parent, static_cast<int>(i)), static_cast<int>(i)};
+        std::sort(buffers.order.begin(), buffers.order.end());
+
+        mask.create(bird_size, CV_8UC1);
+        mask.setTo(cv::Scalar::all(0));
+        size_t kept = 0;
+        std::vector<cv::Point> &outline = buffers.outline;
+        for (size_t i = 0; i < buffers.order.size();) {
+            size_t blob_end = i;
+            while ((blob_end < buffers.order.size()) && (buffers.order[blob_end].first == buffers.order[i].first))
+                blob_end++;
+
+            outline.clear();
+            for (size_t k = i; k < blob_end; k++) {
+                const sparse_buffers::run &r = runs[static_cast<size_t>(buffers.order[k].second)];
+                outline.push_back(to_bird(project(m, r.start, r.row), bird_size));
+            }
+            for (size_t k = blob_end; k-- > i;) {
+                const sparse_buffers::run &r = runs[static_cast<size_t>(buffers.order[k].second)];
+                outline.push_back(to_bird(project(m, r.end - 1, r.row), bird_size));
+            }
+
+            cv::Rect boundingRect = cv::boundingRect(outline);
+            int w = boundingRect.width;
+            int h = boundingRect.height;
+            double Area = cv::contourArea(outline, true);
+            if (((h > w * 5) || ((h > 30) && (h < 100))) && ((w < 50) && (w > 3)) && (Area < 700)) {
+                if (kept == filtered_contours.size())
+                    filtered_contours.emplace_back();
+                filtered_contours[kept++].assign(outline.begin(), outline.end());
+                // Маска: проекция площади каждого отрезка (строка пикселей кадра).
+                for (size_t k = i; k < blob_end; k++) {
+                    const sparse_buffers::run &r = runs[static_cast<size_t>(buffers.order[k].second)];
+                    cv::Point quad[4] = {to_bird(project(m, r.start, r.row), bird_size),
+                                         to_bird(project(m, r.end, r.row), bird_size),
+                                         to_bird(project(m, r.end, r.row + 1), bird_size),
+                                         to_bird(project(m, r.start, r.row + 1), bird_size)};
+                    cv::fillConvexPoly(mask, quad, 4, cv::Scalar(255));
+                }
+            }
+            i = blob_end;
+        }
+        filtered_contours.resize(kept);
+
+        // Точки контуров в обратном порядке контуров, как в filtered_img().
+        filtered_coord.clear();
+        for (size_t i = kept; i-- > 0;)
+            filtered_coord.append(filtered_contours[i]);
+    }
+
+}
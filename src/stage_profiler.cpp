@@ -0,0 +1,208 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * Возвращает название этапа обработки кадра.
+ */
+    const char* stage_name(stage s) {
+        static const char* names[stage_count] = {
+                "capture", "change", "coarse", "warp", "threshold", "contours", "ransac", "stripes",
+                "association", "polyfit", "dashes", "smoothing", "distance", "render"
+        };
+        size_t i = static_cast<size_t>(s);
+        return i < stage_count ? names[i] : "?";
+    }
+
+
+/**
+ * Номер интервала гистограммы для значения.
+ * Значения меньше 2^sub_bits хранятся точно, далее каждая степень двойки делится на 2^(sub_bits-1) интервалов.
+ *
+ * @param ns - значение, нс.
+ * @return Номер интервала.
+ */
+    size_t latency_histogram::bucket_index(uint64_t ns) {
+        if (ns < (uint64_t(1) << sub_bits))
+            return static_cast<size_t>(ns);
+        size_t msb = 63 - static_cast<size_t>(__builtin_clzll(ns));
+        size_t group = msb - sub_bits + 1;
+        size_t index = (group << (sub_bits - 1)) + static_cast<size_t>(ns >> group);
+        return std::min(index, bucket_count - 1);
+    }
+
+/**
+ * Нижняя граница интервала гистограммы.
+ *
+ * @param index - номер интервала.
+ * @return Значение, нс.
+ */
+    uint64_t latency_histogram::bucket_value(size_t index) {
+        if (index < (size_t(1) << sub_bits))
+            return index;
+        size_t group = (index >> (sub_bits - 1)) - 1;
+        uint64_t top = index - (group << (sub_bits - 1));
+        return top << group;
+    }
+
+    void latency_histogram::record(uint64_t ns) {
+        buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t prev = max_ns.load(std::memory_order_relaxed);
+        while ((ns > prev) && !max_ns.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t latency_histogram::count() const {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram::max() const {
+        return max_ns.load(std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram::sum() const {
+        return sum_ns.load(std::memory_order_relaxed);
+    }
+
+/**
+ * Значение квантиля. Возвращается середина интервала, в который попал квантиль
+ * (но не больше максимального записанного значения).
+ *
+ * @param q - квантиль от 0 до 1.
+ * @return Значение, нс (0, если записей нет).
+ */
+    uint64_t latency_histogram::quantile(double q) const {
+        uint64_t n = count();
+        if (n == 0)
+            return 0;
+        auto rank = static_cast<uint64_t>(q * static_cast<double>(n - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t low = bucket_value(i);
+                uint64_t high = (i + 1 < bucket_count) ? bucket_value(i + 1) : low;
+                return std::min(low + (high - low) / 2, max());
+            }
+        }
+        return max();
+    }
+
+    void latency_histogram::reset() {
+        for (auto &b : buckets)
+            b.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum_ns.store(0, std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+    }
+
+
+
+    void stage_profiler::record(stage s, uint64_t ns) {
+        histograms[static_cast<size_t>(s)].record(ns);
+    }
+
+    const latency_histogram& stage_profiler::histogram(stage s) const {
+        return histograms[static_cast<size_t>(s)];
+    }
+
+    void stage_profiler::reset() {
+        for (auto &h : histograms)
+            h.reset();
+        for (size_t i = 0; i < stage_count; i++) {
+            for (auto &sum : counter_sums[i])
+                sum.store(0, std::memory_order_relaxed);
+            counter_samples[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+/**
+ * Включает аппаратные счётчики. Доступность проверяется в вызывающем потоке,
+ * остальные потоки открывают свои счётчики при первом замере этапа.
+ *
+ * @return false, если счётчики недоступны (например, kernel.perf_event_paranoid > 2). Таймеры продолжают работать.
+ */
+    bool stage_profiler::enable_counters() {
+        perf_counters &counters = perf_counters::this_thread();
+        if (!counters.is_open()) {
+            std::cout << "Счётчики производительности недоступны: " << counters.error() << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < perf_event_count; i++)
+            counters_supported[i] = counters.supported(static_cast<perf_event_kind>(i));
+        counters_on.store(true, std::memory_order_release);
+        return true;
+    }
+
+    bool stage_profiler::counters_enabled() const {
+        return counters_on.load(std::memory_order_relaxed);
+    }
+
+    void stage_profiler::record_counters(stage s, const perf_values& delta) {
+        size_t i = static_cast<size_t>(s);
+        for (size_t k = 0; k < perf_event_count; k++)
+            counter_sums[i][k].fetch_add(delta[k], std::memory_order_relaxed);
+        counter_samples[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+/**
+ * Выводит таблицу задержек по этапам: количество замеров, p50, p90, p99 и максимум в миллисекундах.
+ *
+ * @param out - поток вывода.
+ */
+    void stage_profiler::report(std::ostream& out) const {
+        auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+        out << "\nЗадержки по этапам, мс:\n";
+        out << std::left << std::setw(14) << "stage" << std::right
+            << std::setw(10) << "count" << std::setw(10) << "p50" << std::setw(10) << "p90"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+        out << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < stage_count; i++) {
+            const latency_histogram &h = histograms[i];
+            if (h.count() == 0)
+                continue;
+            out << std::left << std::setw(14) << stage_name(static_cast<stage>(i)) << std::right
+                << std::setw(10) << h.count()
+                << std::setw(10) << ms(h.quantile(0.50))
+                << std::setw(10) << ms(h.quantile(0.90))
+                << std::setw(10) << ms(h.quantile(0.99))
+                << std::setw(10) << ms(h.max()) << "\n";
+        }
+
+        if (counters_enabled()) {
+            // Значения счётчиков на один проход этапа (один кадр); "-" - счётчик не поддерживается.
+            auto per_frame = [&](size_t i, perf_event_kind kind, uint64_t samples) {
+                size_t k = static_cast<size_t>(kind);
+                std::ostringstream ss;
+                if (counters_supported[k])
+                    ss << std::fixed << std::setprecision(0)
+                       << static_cast<double>(counter_sums[i][k].load(std::memory_order_relaxed)) / static_cast<double>(samples);
+                else
+                    ss << "-";
+                return ss.str();
+            };
+            out << "\nАппаратные счётчики на кадр:\n";
+            out << std::left << std::setw(14) << "stage" << std::right << std::setw(8) << "IPC"
+                << std::setw(14) << "cycles" << std::setw(14) << "cache-miss" << std::setw(14) << "branch-miss" << "\n";
+            for (size_t i = 0; i < stage_count; i++) {
+                uint64_t samples = counter_samples[i].load(std::memory_order_relaxed);
+                if (samples == 0)
+                    continue;
+                uint64_t cycles = counter_sums[i][static_cast<size_t>(perf_event_kind::cycles)].load(std::memory_order_relaxed);
+                uint64_t instructions = counter_sums[i][static_cast<size_t>(perf_event_kind::instructions)].load(std::memory_order_relaxed);
+                out << std::left << std::setw(14) << stage_name(static_cast<stage>(i)) << std::right << std::setw(8);
+                if (counters_supported[static_cast<size_t>(perf_event_kind::instructions)] && (cycles > 0))
+                    out << std::setprecision(2) << static_cast<double>(instructions) / static_cast<double>(cycles);
+                else
+                    out << "-";
+                out << std::setw(14) << per_frame(i, perf_event_kind::cycles, samples)
+                    << std::setw(14) << per_frame(i, perf_event_kind::cache_misses, samples)
+                    << std::setw(14) << per_frame(i, perf_event_kind::branch_misses, samples) << "\n";
+            }
+        }
+        out << std::defaultfloat << std::flush;
+    }
+
+}
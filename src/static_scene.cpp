@@ -0,0 +1,51 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * scene_signature - сигнатура дороги: средняя яркость клеток прямоугольника, описанного вокруг
+ * трапеции parametersBird (signature_cols x signature_rows). Кадр уменьшается с усреднением
+ * (INTER_AREA, каждый пиксель читается один раз), в оттенки серого переводится уже уменьшенное изображение.
+ *
+ * @param frame - кадр BGR или яркость кадра YUV.
+ * @param parametersBird - параметры bird преобразования (точки 1-4 - трапеция).
+ * @param small - уменьшенный кадр BGR (промежуточный буфер).
+ * @param signature - результат, CV_8UC1. Пустой, если трапеция вне кадра.
+ */
+    void scene_signature(const cv::Mat& frame, const std::vector<int>& parametersBird, cv::Mat& small, cv::Mat& signature) {
+        int left = frame.cols, top = frame.rows, right = 0, bottom = 0;
+        for (size_t i = 0; i < 8; i += 2) {
+            left = std::min(left, parametersBird[i]);
+            right = std::max(right, parametersBird[i]);
+            top = std::min(top, parametersBird[i + 1]);
+            bottom = std::max(bottom, parametersBird[i + 1]);
+        }
+        cv::Rect roi = cv::Rect(left, top, right - left + 1, bottom - top + 1) & cv::Rect(0, 0, frame.cols, frame.rows);
+        if (roi.empty()) {
+            signature.release();
+            return;
+        }
+
+        cv::Size size(signature_cols, signature_rows);
+        if (frame.channels() == 1) {
+            cv::resize(frame(roi), signature, size, 0, 0, cv::INTER_AREA);
+        } else {
+            cv::resize(frame(roi), small, size, 0, 0, cv::INTER_AREA);
+            cv::cvtColor(small, signature, cv::COLOR_BGR2GRAY);
+        }
+    }
+
+/**
+ * signature_change - изменение сцены между сигнатурами: наибольшая разница средней яркости клетки.
+ * Одна клетка с другой машиной или пешеходом даёт большую разницу, шум камеры усредняется внутри клеток.
+ *
+ * @return разница в уровнях яркости; 255, если сигнатуры нельзя сравнить.
+ */
+    double signature_change(const cv::Mat& signature, const cv::Mat& reference) {
+        if (signature.empty() || (signature.size() != reference.size()) || (signature.type() != reference.type()))
+            return 255;
+        return cv::norm(signature, reference, cv::NORM_INF);
+    }
+
+}
@@ -0,0 +1,110 @@
+#include "../include/Ransac.h"
+
+namespace RansacNamespace {
+
+
+/**
+ * Конструктор генератора.
+ *
+ * @param config - параметры детекции (parametersBird для базового кадра и parametersHSV для цвета разметки).
+ * @param p - параметры сцены.
+ */
+    synthetic_road::synthetic_road(const settings& config, const synthetic_params& p) : params(p) {
+        params.lanes = std::min(params.lanes, max_stripes);
+        scale_x = static_cast<double>(params.width) / params.base_width;
+        scale_y = static_cast<double>(params.height) / params.base_height;
+
+        // Точки трапеции масштабируются к размеру кадра, размер изображения сверху - вместе с ними.
+        parametersBird = config.parametersBird;
+        for (size_t i = 0; i < 8; i++)
+            parametersBird[i] = static_cast<int>(std::lround(parametersBird[i] * ((i % 2 == 0) ? scale_x : scale_y)));
+        parametersBird[8] = static_cast<int>(std::lround(parametersBird[8] * scale_y));
+        parametersBird[9] = static_cast<int>(std::lround(parametersBird[9] * scale_x));
+        matrixBird = Bird_view::return_bird_matrix(parametersBird);
+
+        // Цвет разметки - середина диапазона цветового фильтра (HLS).
+        const std::vector<int> &hls = config.parametersHSV;
+        cv::Mat color(1, 1, CV_8UC3, cv::Scalar((hls[0] + hls[3]) / 2, (hls[1] + hls[4]) / 2, (hls[2] + hls[5]) / 2));
+        cv::cvtColor(color, color, cv::COLOR_HLS2BGR);
+        cv::Vec3b c = color.at<cv::Vec3b>(0, 0);
+        paint = cv::Scalar(c[0], c[1], c[2]);
+    }
+
+    const std::vector<int>& synthetic_road::bird_parameters() const {
+        return parametersBird;
+    }
+
+    void synthetic_road::render(uint64_t frame, cv::Mat& out, lane_polys& truth, std::vector<bool>& solid) {
+        int bird_h = parametersBird[8];
+        int bird_w = parametersBird[9];
+        double t = static_cast<double>(frame);
+        double phase = 2 * M_PI * t / params.period;
+
+        // Кривизна в пикселях масштабированного изображения сверху.
+        double a = params.curvature * std::sin(phase) * scale_x / (scale_y * scale_y);
+        double offset = params.sway * scale_x * std::sin(0.5 * phase);
+        double line_width = std::max(1.0, params.line_width * scale_x);
+        double dash = params.dash_length * scale_y;
+        double dash_period = (params.dash_length + params.dash_gap) * scale_y;
+        double shift = std::fmod(params.speed * scale_y * t, dash_period);
+
+        cv::Mat bird(bird_h, bird_w, CV_8UC3, cv::Scalar(70, 70, 70));
+        truth.reset(params.lanes);
+        solid.clear();
+
+        for (size_t k = 0; k < params.lanes; k++) {
+            // x = a*(y - H)^2 + x0: положение линии у нижнего края не зависит от кривизны.
+            double x0 = bird_w * (static_cast<double>(k) + 0.5) / static_cast<double>(params.lanes) + offset;
+            double H = bird_h;
+            truth[k] = {static_cast<float>(a), static_cast<float>(-2 * a * H), static_cast<float>(a * H * H + x0)};
+            bool is_solid = (k == 0) || (k + 1 == params.lanes);
+            solid.push_back(is_solid);
+
+            for (int y = 0; y + 2 <= bird_h; y += 2) {
+                if (!is_solid && (std::fmod(y + dash_period - shift, dash_period) >= dash))
+                    continue;
+                double y1 = y, y2 = y + 2;
+                cv::Point p1(static_cast<int>(a * (y1 - H) * (y1 - H) + x0), y);
+                cv::Point p2(static_cast<int>(a * (y2 - H) * (y2 - H) + x0), y + 2);
+                cv::line(bird, p1, p2, paint, static_cast<int>(line_width));
+            }
+        }
+
+        cv::RNG rng(params.seed * 1000003 + frame);
+
+        // Ложные пятна цвета разметки и других цветов.
+        for (size_t i = 0; i < params.clutter; i++) {
+            cv::Point c(rng.uniform(0, bird_w), rng.uniform(0, bird_h));
+            cv::Scalar color = (i % 2 == 0) ? paint : cv::Scalar(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
+            cv::circle(bird, c, rng.uniform(2, 2 + static_cast<int>(8 * scale_x)), color, cv::FILLED);
+        }
+
+        // Тени - затемнённые четырёхугольники, движущиеся вместе с дорогой.
+        for (size_t i = 0; i < params.shadows; i++) {
+            cv::RNG shadow_rng(params.seed * 7919 + i);
+            int x = shadow_rng.uniform(0, bird_w);
+            int w = shadow_rng.uniform(bird_w / 8, bird_w / 2);
+            int h = shadow_rng.uniform(bird_h / 8, bird_h / 3);
+            int y = static_cast<int>(std::fmod(params.speed * scale_y * t + shadow_rng.uniform(0, 2 * bird_h), 2.0 * bird_h)) - h;
+            cv::Point quad[4] = {{x, y}, {x + w, y + h / 4}, {x + w - w / 4, y + h}, {x - w / 4, y + h - h / 4}};
+            cv::Mat mask = cv::Mat::zeros(bird.size(), CV_8UC1);
+            cv::fillConvexPoly(mask, quad, 4, cv::Scalar(255));
+            cv::Mat dark = bird * 0.5;
+            dark.copyTo(bird, mask);
+        }
+
+        // Фон за пределами трапеции, затем дорога в перспективе камеры.
+        out.create(params.height, params.width, CV_8UC3);
+        out.setTo(cv::Scalar(120, 110, 100));
+        cv::warpPerspective(bird, out, matrixBird[1], out.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+        if (params.noise > 0) {
+            cv::Mat img16, n(out.size(), CV_16SC3);
+            cv::randn(n, cv::Scalar::all(0), cv::Scalar::all(params.noise));
+            out.convertTo(img16, CV_16SC3);
+            img16 = img16 + n;
+            img16.convertTo(out, CV_8UC3);
+        }
+    }
+
+}
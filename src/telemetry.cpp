@@ -0,0 +1,268 @@
+#include "../include/Ransac.h"
+
+#include <cstring>
+#include <cstdio>
+
+namespace RansacNamespace {
+
+
+/**
+ * fill_frame_record - заполняет запись телеметрии результатами обработки кадра.
+ *
+ * @param rec - заполняемая запись.
+ * @param frame - номер кадра.
+ * @param lines - вектор линий (полиномов) по полосам.
+ * @param result_type_of_lines - типы линий (1 - сплошная, 0 - прерывистая).
+ * @param lines_detected - флаг обнаружения линий.
+ * @param left_right_distance - расстояния до левой и правой линии.
+ * @param three_points - три точки левой и правой линии.
+ * @param frame_time - время обработки кадра, с.
+ */
+    void fill_frame_record(frame_record& rec, uint64_t frame, const lane_polys& lines, const stripe_flags& result_type_of_lines,
+                           bool lines_detected, const std::vector<double>& left_right_distance,
+                           const std::vector<std::vector<cv::Point2d>>& three_points, double frame_time) {
+        std::memset(&rec, 0, sizeof(rec));
+        rec.frame = frame;
+        rec.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        rec.stripes = static_cast<uint32_t>(std::min(lines.size(), telemetry_max_stripes));
+        rec.lines_detected = lines_detected ? 1 : 0;
+
+        for (size_t i = 0; i < rec.stripes; i++) {
+            rec.coefs[i][0] = lines[i].a;
+            rec.coefs[i][1] = lines[i].b;
+            rec.coefs[i][2] = lines[i].c;
+            rec.solid[i] = result_type_of_lines[i] ? 1 : 0;
+        }
+
+        if (left_right_distance.size() >= 2) {
+            rec.distance[0] = left_right_distance[0];
+            rec.distance[1] = left_right_distance[1];
+        }
+
+        for (size_t j = 0; j < std::min(three_points.size(), size_t(2)); j++) {
+            for (size_t i = 0; i < std::min(three_points[j].size(), size_t(3)); i++) {
+                rec.three_points[j][i][0] = three_points[j][i].x;
+                rec.three_points[j][i][1] = three_points[j][i].y;
+            }
+        }
+        rec.frame_time = frame_time;
+    }
+
+
+/**
+ * fill_shm_frame - переносит результаты кадра из записи телеметрии в кадр разделяемой памяти.
+ *
+ * @param out - заполняемый кадр.
+ * @param rec - запись телеметрии.
+ * @param capture_ns - время получения кадра (CLOCK_MONOTONIC), нс.
+ */
+    void fill_shm_frame(lane_shm_frame& out, const frame_record& rec, int64_t capture_ns) {
+        std::memset(&out, 0, sizeof(out));
+        out.frame = rec.frame;
+        out.capture_ns = capture_ns;
+        out.stripes = static_cast<uint32_t>(std::min(static_cast<size_t>(rec.stripes), lane_shm_max_stripes));
+        out.lines_detected = rec.lines_detected;
+        for (size_t i = 0; i < out.stripes; i++) {
+            out.solid[i] = rec.solid[i];
+            for (size_t k = 0; k < 3; k++)
+                out.coefs[i][k] = rec.coefs[i][k];
+        }
+        out.distance[0] = rec.distance[0];
+        out.distance[1] = rec.distance[1];
+    }
+
+
+    void telemetry_encoder::header(std::string& /*out*/) {}
+
+    bool telemetry_encoder::binary() const {
+        return false;
+    }
+
+/**
+ * Создает кодировщик по названию формата.
+ *
+ * @param format - "jsonl", "csv" или "bin".
+ * @return Кодировщик или nullptr, если формат неизвестен.
+ */
+    std::unique_ptr<telemetry_encoder> telemetry_encoder::create(const std::string& format) {
+        if (format == "jsonl" || format == "json")
+            return std::make_unique<json_lines_encoder>();
+        if (format == "csv")
+            return std::make_unique<csv_encoder>();
+        if (format == "bin")
+            return std::make_unique<binary_encoder>();
+        return nullptr;
+    }
+
+
+/**
+ * Кодирует запись в одну строку JSON.
+ */
+    void json_lines_encoder::encode(const frame_record& rec, std::string& out) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"frame\":%llu,\"t_ns\":%lld,\"detected\":%d,\"time\":%.6f,\"lines\":[",
+                 static_cast<unsigned long long>(rec.frame), static_cast<long long>(rec.timestamp_ns),
+                 rec.lines_detected, rec.frame_time);
+        out += buf;
+        for (size_t i = 0; i < rec.stripes; i++) {
+            snprintf(buf, sizeof(buf), "%s{\"coefs\":[%.9g,%.9g,%.9g],\"solid\":%d}", i ? "," : "",
+                     rec.coefs[i][0], rec.coefs[i][1], rec.coefs[i][2], rec.solid[i]);
+            out += buf;
+        }
+        snprintf(buf, sizeof(buf), "],\"left\":%.4f,\"right\":%.4f,\"points\":[", rec.distance[0], rec.distance[1]);
+        out += buf;
+        for (size_t j = 0; j < 2; j++) {
+            out += j ? ",[" : "[";
+            for (size_t i = 0; i < 3; i++) {
+                snprintf(buf, sizeof(buf), "%s[%.4f,%.4f]", i ? "," : "",
+                         rec.three_points[j][i][0], rec.three_points[j][i][1]);
+                out += buf;
+            }
+            out += "]";
+        }
+        out += "]}\n";
+    }
+
+
+    void csv_encoder::header(std::string& out) {
+        out += "frame,t_ns,detected,time,left,right";
+        for (size_t i = 0; i < telemetry_max_stripes; i++) {
+            std::string n = std::to_string(i);
+            out += ",a" + n + ",b" + n + ",c" + n + ",solid" + n;
+        }
+        out += "\n";
+    }
+
+/**
+ * Кодирует запись в строку CSV с фиксированным числом столбцов (пустые полосы заполняются нулями).
+ */
+    void csv_encoder::encode(const frame_record& rec, std::string& out) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%llu,%lld,%d,%.6f,%.4f,%.4f",
+                 static_cast<unsigned long long>(rec.frame), static_cast<long long>(rec.timestamp_ns),
+                 rec.lines_detected, rec.frame_time, rec.distance[0], rec.distance[1]);
+        out += buf;
+        for (size_t i = 0; i < telemetry_max_stripes; i++) {
+            snprintf(buf, sizeof(buf), ",%.9g,%.9g,%.9g,%d",
+                     rec.coefs[i][0], rec.coefs[i][1], rec.coefs[i][2], rec.solid[i]);
+            out += buf;
+        }
+        out += "\n";
+    }
+
+
+/**
+ * Заголовок двоичного потока: сигнатура "LTEL", версия и размер записи.
+ */
+    void binary_encoder::header(std::string& out) {
+        uint32_t head[3] = {0x4c45544c, 1, static_cast<uint32_t>(sizeof(frame_record))};
+        out.append(reinterpret_cast<const char*>(head), sizeof(head));
+    }
+
+    void binary_encoder::encode(const frame_record& rec, std::string& out) {
+        out.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    }
+
+    bool binary_encoder::binary() const {
+        return true;
+    }
+
+
+
+/**
+ * Конструктор. Открывает файл вывода и запускает фоновый поток записи.
+ *
+ * @param enc - кодировщик записей.
+ * @param path - путь к файлу (пустая строка - stdout).
+ * @param rate_hz - максимальная частота записей, Гц (0 - без ограничения).
+ * @param queue_size - размер очереди.
+ */
+    telemetry::telemetry(std::unique_ptr<telemetry_encoder> enc, const std::string& path, double rate_hz, size_t queue_size)
+            : encoder(std::move(enc)), queue(queue_size), out(stdout),
+              min_interval_ns(rate_hz > 0 ? static_cast<int64_t>(1e9 / rate_hz) : 0),
+              last_timestamp_ns(0), running(true), dropped_count(0), skipped_count(0) {
+        if (!encoder)
+            encoder = std::make_unique<json_lines_encoder>();
+        if (!path.empty()) {
+            out = fopen(path.c_str(), encoder->binary() ? "wb" : "w");
+            if (out == nullptr) {
+                std::cout << "Ошибка: не удалось открыть файл телеметрии " << path << std::endl;
+                out = stdout;
+            }
+        }
+        writer = std::thread(&telemetry::run, this);
+    }
+
+/**
+ * Деструктор. Дожидается записи оставшихся в очереди данных и закрывает файл.
+ */
+    telemetry::~telemetry() {
+        running.store(false, std::memory_order_release);
+        if (writer.joinable())
+            writer.join();
+        if (out != stdout)
+            fclose(out);
+    }
+
+/**
+ * Помещает запись в очередь. Вызывается из цикла обработки: не форматирует текст и не блокируется.
+ *
+ * @param rec - запись телеметрии.
+ * @return false, если запись пропущена ограничением частоты или очередь заполнена.
+ */
+    bool telemetry::publish(const frame_record& rec) {
+        if ((min_interval_ns > 0) && (last_timestamp_ns != 0) &&
+            (rec.timestamp_ns - last_timestamp_ns < min_interval_ns)) {
+            skipped_count++;
+            return false;
+        }
+        if (!queue.push(rec)) {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        last_timestamp_ns = rec.timestamp_ns;
+        return true;
+    }
+
+    size_t telemetry::dropped() const {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+    size_t telemetry::skipped() const {
+        return skipped_count;
+    }
+
+/**
+ * Фоновый поток: извлекает записи из очереди, кодирует и пишет их пачками.
+ */
+    void telemetry::run() {
+        std::string buffer;
+        buffer.reserve(1 << 16);
+        encoder->header(buffer);
+
+        frame_record rec{};
+        while (true) {
+            bool stop = !running.load(std::memory_order_acquire);
+            bool any = false;
+            while (queue.pop(rec)) {
+                encoder->encode(rec, buffer);
+                any = true;
+                if (buffer.size() > (1 << 15)) {
+                    fwrite(buffer.data(), 1, buffer.size(), out);
+                    buffer.clear();
+                }
+            }
+            if (!buffer.empty()) {
+                fwrite(buffer.data(), 1, buffer.size(), out);
+                fflush(out);
+                buffer.clear();
+            }
+            if (stop)
+                break;
+            if (!any)
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+}
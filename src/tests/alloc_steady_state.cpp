@@ -0,0 +1,270 @@
+#include "../../include/Ransac.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+/**
+ * Проверка: после прогрева LaneDetector::process не выделяет память в коде проекта -
+ * ни через operator new, ни через malloc/calloc/realloc/posix_memalign (буферы cv::Mat, Eigen).
+ *
+ * operator new: выделение относится к коду, вызвавшему operator new - первый кадр стека
+ * вне libstdc++/libc. Кадр в исполняемом файле (lanedetect собирается статически) - выделение проекта,
+ * кадр в другой библиотеке (mrpt::ransac_detect_2D_lines, cv::findContours) - выделение библиотеки.
+ *
+ * malloc и др. подменяются в этом исполняемом файле поверх __libc_malloc и др., поэтому сюда приходят
+ * и выделения из библиотек (cv::fastMalloc). Прямой вызов из проекта (Eigen, malloc) - выделение проекта.
+ * Данные cv::Mat (в стеке есть cv::Mat::create) относятся к ближайшему кадру проекта выше по стеку:
+ * Mat::zeros, clone, copyTo в проекте и выходные массивы функций OpenCV, вызванных проектом
+ * (cv::erode, cv::warpPerspective, cv::inRange), при смене размера или без переиспользования буфера -
+ * выделения проекта. Исключение - функции с временными Mat внутри (internal_temporaries).
+ * Остальные выделения - выделения библиотек.
+ *
+ * Выделения библиотек только выводятся: их количество зависит от версии библиотеки и данных кадра.
+ * Код возврата 1, если в коде проекта есть выделения; выводятся адреса вызовов для addr2line.
+ */
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+
+    constexpr size_t warmup_frames = 64;
+    constexpr size_t measured_frames = 64;
+    constexpr size_t max_reported = 8;
+
+    std::atomic<bool> counting{false};
+    thread_local bool inside = false;
+    std::atomic<uint64_t> project_allocations{0};
+    std::atomic<uint64_t> library_allocations{0};
+    std::atomic<uint64_t> project_buffers{0};
+    std::atomic<uint64_t> library_buffers{0};
+    const void *executable_base = nullptr;
+    void *reported[max_reported];
+    std::atomic<size_t> reported_count{0};
+
+    /// Адрес в этом исполняемом файле: по нему dladdr() находит базу исполняемого файла.
+    int anchor;
+
+    bool runtime_library(const char* name) {
+        return (name != nullptr) && ((std::strstr(name, "libstdc++") != nullptr) ||
+                                     (std::strstr(name, "libc.so") != nullptr) || (std::strstr(name, "libgcc") != nullptr));
+    }
+
+    /// Функции OpenCV, создающие временные cv::Mat при каждом вызове (findContours копирует изображение с рамкой).
+    const char *internal_temporaries[] = {"cv::findContours"};
+
+    void report(void* address) {
+        size_t k = reported_count.fetch_add(1, std::memory_order_relaxed);
+        if (k < max_reported)
+            reported[k] = address;
+    }
+
+    /// Относит выделение к проекту или библиотеке, начиная с адреса возврата из operator new.
+    void classify(void* caller) {
+        void *stack[32];
+        int depth = backtrace(stack, 32);
+        int first = 0;
+        while ((first < depth) && (stack[first] != caller))
+            first++;
+        if (first == depth) {
+            stack[0] = caller;
+            first = 0;
+            depth = 1;
+        }
+        for (int i = first; i < depth; i++) {
+            Dl_info info{};
+            if (dladdr(stack[i], &info) == 0)
+                continue;
+            if (info.dli_fbase == executable_base) {
+                project_allocations.fetch_add(1, std::memory_order_relaxed);
+                report(stack[i]);
+                return;
+            }
+            if (!runtime_library(info.dli_fname))
+                break;
+        }
+        library_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Функция библиотеки, вызванная из проекта, создаёт временные cv::Mat (см. internal_temporaries).
+    bool creates_temporaries(const char* mangled) {
+        if (mangled == nullptr)
+            return false;
+        int status = 0;
+        char *name = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+        bool found = false;
+        for (const char *entry : internal_temporaries)
+            found = found || ((name != nullptr) && (std::strstr(name, entry) == name));
+        std::free(name);
+        return found;
+    }
+
+    /**
+     * Относит выделение malloc и др. к проекту или библиотеке, начиная с адреса возврата из malloc.
+     * Данные cv::Mat (кадр cv::Mat::create в стеке) - к ближайшему кадру проекта, остальное - к первому кадру вне libc.
+     */
+    void classify_buffer(void* caller) {
+        void *stack[48];
+        int depth = backtrace(stack, 48);
+        int first = 0;
+        while ((first < depth) && (stack[first] != caller))
+            first++;
+        if (first == depth) {
+            stack[0] = caller;
+            first = 0;
+            depth = 1;
+        }
+        bool mat_data = false, direct = true;
+        const char *callee = nullptr;
+        for (int i = first; i < depth; i++) {
+            Dl_info info{};
+            if (dladdr(stack[i], &info) == 0)
+                continue;
+            if (info.dli_fbase == executable_base) {
+                // Прямой вызов из проекта или данные cv::Mat, созданные по вызову из проекта.
+                if (direct || (mat_data && !creates_temporaries(callee))) {
+                    project_buffers.fetch_add(1, std::memory_order_relaxed);
+                    report(stack[i]);
+                    return;
+                }
+                break;
+            }
+            if (runtime_library(info.dli_fname))
+                continue;
+            // Кадры библиотек до первого кадра проекта: был ли среди них cv::Mat::create и какая функция вызвана из проекта.
+            direct = false;
+            mat_data = mat_data || ((info.dli_sname != nullptr) && (std::strstr(info.dli_sname, "N2cv3Mat6createE") != nullptr));
+            callee = info.dli_sname;
+        }
+        library_buffers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Учёт выделения malloc и др. во время замера (без повторного входа из backtrace и dladdr).
+    void count_buffer(void* caller) {
+        if (counting.load(std::memory_order_relaxed) && !inside) {
+            inside = true;
+            classify_buffer(caller);
+            inside = false;
+        }
+    }
+}
+
+
+extern "C" {
+
+__attribute__((noinline)) void* malloc(size_t size) noexcept {
+    count_buffer(__builtin_return_address(0));
+    return __libc_malloc(size);
+}
+
+__attribute__((noinline)) void* calloc(size_t count, size_t size) noexcept {
+    count_buffer(__builtin_return_address(0));
+    return __libc_calloc(count, size);
+}
+
+__attribute__((noinline)) void* realloc(void* p, size_t size) noexcept {
+    count_buffer(__builtin_return_address(0));
+    return __libc_realloc(p, size);
+}
+
+__attribute__((noinline)) int posix_memalign(void** p, size_t alignment, size_t size) noexcept {
+    if ((alignment % sizeof(void*) != 0) || ((alignment & (alignment - 1)) != 0))
+        return EINVAL;
+    count_buffer(__builtin_return_address(0));
+    *p = __libc_memalign(alignment, size);
+    return (*p != nullptr) ? 0 : ENOMEM;
+}
+
+__attribute__((noinline)) void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    count_buffer(__builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+__attribute__((noinline)) void* memalign(size_t alignment, size_t size) noexcept {
+    count_buffer(__builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+}
+
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed) && !inside) {
+        inside = true;
+        classify(__builtin_return_address(0));
+        inside = false;
+    }
+    // Мимо подменённого malloc: выделение уже учтено как operator new.
+    if (void *p = __libc_malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+int main() {
+    using namespace RansacNamespace;
+
+    Dl_info self{};
+    if (dladdr(&anchor, &self) == 0) {
+        std::cout << "Ошибка: dladdr не нашёл исполняемый файл" << std::endl;
+        return 1;
+    }
+    executable_base = self.dli_fbase;
+    void *probe[4];
+    backtrace(probe, 4); // Первый вызов загружает libgcc_s и выделяет память.
+
+    settings init;
+    synthetic_params params;
+    synthetic_road road(init, params);
+    init.parametersBird = road.bird_parameters();
+
+    std::vector<cv::Mat> frames(32);
+    lane_polys truth{};
+    std::vector<bool> solid;
+    for (size_t i = 0; i < frames.size(); i++)
+        road.render(i, frames[i], truth, solid);
+
+    LaneDetector detector(init);
+    LaneDetector::Result result;
+    for (size_t i = 0; i < warmup_frames; i++)
+        detector.process(frames[i % frames.size()], result);
+
+    counting.store(true, std::memory_order_relaxed);
+    for (size_t i = 0; i < measured_frames; i++)
+        detector.process(frames[(warmup_frames + i) % frames.size()], result);
+    counting.store(false, std::memory_order_relaxed);
+
+    uint64_t project = project_allocations.load() + project_buffers.load();
+    std::cout << "Выделений за " << measured_frames << " кадров после прогрева: operator new - проект "
+              << project_allocations.load() << ", библиотеки " << library_allocations.load()
+              << "; malloc (cv::Mat, Eigen) - проект " << project_buffers.load() << ", библиотеки "
+              << library_buffers.load() << std::endl;
+    if (project == 0)
+        return 0;
+
+    std::cout << "Ошибка: выделения памяти в коде проекта. Адреса вызовов (addr2line -f -C -e " << self.dli_fname
+              << "):" << std::endl;
+    size_t n = std::min(reported_count.load(), max_reported);
+    for (size_t k = 0; k < n; k++) {
+        auto offset = reinterpret_cast<uintptr_t>(reported[k]) - reinterpret_cast<uintptr_t>(executable_base);
+        std::cout << "  0x" << std::hex << offset << std::dec << std::endl;
+    }
+    return 1;
+}
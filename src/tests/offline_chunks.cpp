@@ -0,0 +1,99 @@
+#include "../../include/Ransac.h"
+
+#include <cstdio>
+
+/**
+ * Проверка process_offline(): обработка синтетического видео одной частью и четырьмя частями
+ * даёт одинаковые записи кадров. Перекрытие по умолчанию (30 кадров) должно покрывать сглаживание.
+ * RANSAC MRPT выбирает точки случайно, поэтому полиномы и расстояния сравниваются с допуском
+ * (как в lane_regress), номера кадров, количество полос и типы линий - точно.
+ *
+ * Использование: test_offline_chunks [временный файл видео]
+ */
+
+namespace {
+
+    constexpr uint64_t clip_frames = 240;
+
+    /// Допуски коэффициентов a, b, c и расстояний, м.
+    constexpr double tol_a = 1e-6;
+    constexpr double tol_b = 1e-3;
+    constexpr double tol_c = 1.0;
+    constexpr double tol_dist = 0.05;
+
+    bool run(const RansacNamespace::settings& init, size_t chunks, std::vector<RansacNamespace::frame_record>& records,
+             RansacNamespace::offline_stats& stats) {
+        RansacNamespace::offline_options options;
+        options.chunks = chunks;
+        return RansacNamespace::process_offline(init, options, [&records](const RansacNamespace::frame_record& rec) {
+            records.push_back(rec);
+        }, stats);
+    }
+
+    bool same(const RansacNamespace::frame_record& a, const RansacNamespace::frame_record& b) {
+        if ((a.frame != b.frame) || (a.stripes != b.stripes) || (a.lines_detected != b.lines_detected))
+            return false;
+        for (size_t k = 0; k < a.stripes; k++) {
+            if ((a.solid[k] != b.solid[k]) || (std::abs(a.coefs[k][0] - b.coefs[k][0]) > tol_a) ||
+                (std::abs(a.coefs[k][1] - b.coefs[k][1]) > tol_b) || (std::abs(a.coefs[k][2] - b.coefs[k][2]) > tol_c))
+                return false;
+        }
+        return (std::abs(a.distance[0] - b.distance[0]) <= tol_dist) && (std::abs(a.distance[1] - b.distance[1]) <= tol_dist);
+    }
+}
+
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "offline_chunks_test.avi";
+
+    RansacNamespace::settings init;
+    RansacNamespace::synthetic_params params;
+    params.width = 640;
+    params.height = 360;
+    params.shadows = 0;
+    params.clutter = 0;
+    RansacNamespace::synthetic_road road(init, params);
+    {
+        // MJPG: каждый кадр ключевой, переход по номеру кадра точный.
+        cv::VideoWriter video(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, cv::Size(params.width, params.height));
+        if (!video.isOpened()) {
+            std::cout << "Ошибка: не удалось открыть " << path << " для записи" << std::endl;
+            return 1;
+        }
+        cv::Mat img;
+        RansacNamespace::lane_polys truth{};
+        std::vector<bool> solid;
+        for (uint64_t frame = 0; frame < clip_frames; frame++) {
+            road.render(frame, img, truth, solid);
+            video.write(img);
+        }
+    }
+    init.video_name = path;
+    init.parametersBird = road.bird_parameters();
+
+    std::vector<RansacNamespace::frame_record> sequential, chunked;
+    RansacNamespace::offline_stats one, four;
+    bool ok = run(init, 1, sequential, one) && run(init, 4, chunked, four);
+    std::remove(path.c_str());
+    if (!ok)
+        return 1;
+
+    std::cout << "Кадров: " << sequential.size() << " и " << chunked.size() << ", частей: " << one.chunks << " и "
+              << four.chunks << ", кадров перекрытия: " << four.warmup_frames << std::endl;
+    if ((sequential.size() != clip_frames) || (chunked.size() != sequential.size())) {
+        std::cout << "Ошибка: количество записей не совпадает с количеством кадров " << clip_frames << std::endl;
+        return 1;
+    }
+    size_t differ = 0;
+    for (size_t i = 0; i < sequential.size(); i++) {
+        if (!same(sequential[i], chunked[i])) {
+            if (differ++ == 0)
+                std::cout << "Ошибка: первый отличающийся кадр " << sequential[i].frame << std::endl;
+        }
+    }
+    if (differ > 0) {
+        std::cout << "Ошибка: отличаются " << differ << " из " << sequential.size() << " кадров" << std::endl;
+        return 1;
+    }
+    return 0;
+}
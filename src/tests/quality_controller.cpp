@@ -0,0 +1,149 @@
+#include "../../include/Ransac.h"
+
+#include <sstream>
+
+/**
+ * Проверка quality_controller на заданных временах этапов (без детектора):
+ * порядок снижения качества при медленной подготовке изображения (слежение, масштаб, точки по строкам,
+ * бюджет), нижние границы, восстановление в обратном порядке при времени меньше 75% цели,
+ * отсутствие изменений в зоне гистерезиса и при target_frame_ms = 0, сохранение формата потока журнала,
+ * ядро эрозии грубого поиска, построенное заново после смены масштаба.
+ */
+
+using namespace RansacNamespace;
+
+namespace {
+
+    bool failed = false;
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cout << "Ошибка: " << what << std::endl;
+            failed = true;
+        }
+    }
+
+    bool same(const quality_knobs& a, const quality_knobs& b) {
+        return (a.roi_margin == b.roi_margin) && (std::abs(a.pyramid_scale - b.pyramid_scale) <= 1e-9) &&
+               (a.scan_step == b.scan_step) && (a.scan_budget == b.scan_budget);
+    }
+
+    std::string describe(const quality_knobs& k) {
+        std::ostringstream out;
+        out << "roi_margin " << k.roi_margin << ", pyramid_scale " << k.pyramid_scale << ", scan_step " << k.scan_step
+            << ", scan_budget " << k.scan_budget;
+        return out.str();
+    }
+
+    settings base_settings() {
+        settings init;
+        init.target_frame_ms = 10;
+        init.quality_window = 2;
+        init.roi_margin = 0;
+        init.pyramid_scale = 1;
+        init.scan_step = 0;
+        init.scan_budget = 1000;
+        init.quality_min_scale = 0.25;
+        init.quality_min_budget = 200;
+        init.quality_roi_margin = 30;
+        init.quality_scan_step = 3;
+        return init;
+    }
+
+    /// Подаёт кадры с заданным временем подготовки изображения и RANSAC, мс, и собирает изменения параметров.
+    void run(quality_controller& quality, stage_profiler& profiler, size_t frames, uint64_t warp_ms, uint64_t ransac_ms,
+             std::vector<quality_knobs>& changes, std::ostream& log) {
+        for (size_t i = 0; i < frames; i++) {
+            profiler.record(stage::warp, warp_ms * 1000000);
+            profiler.record(stage::ransac, ransac_ms * 1000000);
+            if (quality.update(0, profiler, log))
+                changes.push_back(quality.knobs());
+        }
+    }
+
+    quality_knobs knobs(int roi_margin, double scale, int step, size_t budget) {
+        quality_knobs k;
+        k.roi_margin = roi_margin;
+        k.pyramid_scale = scale;
+        k.scan_step = step;
+        k.scan_budget = budget;
+        return k;
+    }
+}
+
+
+int main() {
+    settings init = base_settings();
+    quality_knobs initial = quality_knobs::from(init);
+
+    // Снижение: подготовка изображения дольше RANSAC - сначала слежение и масштаб, затем точки.
+    quality_controller quality(init);
+    stage_profiler profiler;
+    std::vector<quality_knobs> down;
+    std::streamsize precision = std::cout.precision();
+    run(quality, profiler, 40, 12, 3, down, std::cout);
+    expect(std::cout.precision() == precision, "регулятор изменил точность вывода потока журнала");
+
+    std::vector<quality_knobs> expected = {
+            knobs(30, 1, 0, 1000),
+            knobs(30, 0.5, 0, 1000),
+            knobs(30, 0.25, 0, 1000),
+            knobs(30, 0.25, 3, 1000),
+            knobs(30, 0.25, 3, 500),
+            knobs(30, 0.25, 3, 250),
+            knobs(30, 0.25, 3, 200),
+    };
+    expect(down.size() == expected.size(), "шагов снижения " + std::to_string(down.size()) + ", ожидалось " +
+                                           std::to_string(expected.size()));
+    for (size_t i = 0; i < std::min(down.size(), expected.size()); i++)
+        expect(same(down[i], expected[i]), "шаг " + std::to_string(i + 1) + ": " + describe(down[i]) +
+                                           ", ожидалось " + describe(expected[i]));
+    expect(quality.level() == expected.size(), "уровень после снижения " + std::to_string(quality.level()));
+    expect(quality.knobs().pyramid_scale >= init.quality_min_scale - 1e-9, "масштаб ниже quality_min_scale");
+    expect(quality.knobs().scan_budget >= init.quality_min_budget, "бюджет ниже quality_min_budget");
+
+    // Зона гистерезиса (от 75% до 100% цели): параметры не меняются.
+    std::vector<quality_knobs> idle;
+    std::ostringstream log;
+    run(quality, profiler, 20, 4, 4, idle, log);
+    expect(idle.empty(), "изменения при времени кадра между 75% и 100% цели");
+
+    // Восстановление при времени меньше 75% цели: шаги отменяются в обратном порядке.
+    std::vector<quality_knobs> up;
+    run(quality, profiler, 40, 1, 1, up, log);
+    std::vector<quality_knobs> reverse(expected.rbegin() + 1, expected.rend());
+    reverse.push_back(initial);
+    expect(up.size() == reverse.size(), "шагов восстановления " + std::to_string(up.size()) + ", ожидалось " +
+                                        std::to_string(reverse.size()));
+    for (size_t i = 0; i < std::min(up.size(), reverse.size()); i++)
+        expect(same(up[i], reverse[i]), "восстановление " + std::to_string(i + 1) + ": " + describe(up[i]) +
+                                        ", ожидалось " + describe(reverse[i]));
+    expect((quality.level() == 0) && same(quality.knobs(), initial), "качество не вернулось к исходному");
+
+    // target_frame_ms = 0: регулятор выключен.
+    settings off = base_settings();
+    off.target_frame_ms = 0;
+    quality_controller disabled(off);
+    stage_profiler off_profiler;
+    std::vector<quality_knobs> none;
+    run(disabled, off_profiler, 40, 50, 50, none, log);
+    expect(none.empty() && same(disabled.knobs(), quality_knobs::from(off)), "изменения при target_frame_ms = 0");
+
+    // Ядро эрозии грубого поиска после шага масштаба: штрих 1x8 при масштабе 0.25 сжимается ядром в 3 строки
+    // до 6 строк и проходит фильтр (h > 5w); ядро в 5 строк от масштаба 0.5 оставило бы 4 строки.
+    cv::Mat coarse_mask = cv::Mat::zeros(100, 100, CV_8UC1);
+    coarse_mask(cv::Rect(50, 40, 1, 8)).setTo(cv::Scalar::all(255));
+    hsv::filter_buffers filter;
+    std::vector<std::vector<cv::Point>> coarse_contours;
+    point_buffer coarse_coord;
+    hsv::filtered_img(coarse_mask, coarse_contours, coarse_coord, filter, 0.5);
+    hsv::filtered_img(coarse_mask, coarse_contours, coarse_coord, filter, 0.25);
+    expect(filter.kernel.rows == 3, "ядро эрозии после смены масштаба " + std::to_string(filter.kernel.rows) +
+                                    " строк, ожидалось 3");
+    expect(coarse_contours.size() == 1, "штрихов грубого поиска после смены масштаба " +
+                                        std::to_string(coarse_contours.size()) + ", ожидался 1");
+
+    if (!failed)
+        std::cout << "OK" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,632 @@
+#include "../../include/Ransac.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Микро-бенчмарки этапов обработки кадра на синтетических данных.
+ * Параметры перебирают разрешение, количество точек и уровень шума.
+ *
+ * Сравнение между коммитами:
+ *   bench_lanedetect --benchmark_format=json --benchmark_out=bench.json
+ *   compare.py benchmarks old.json new.json   (из поставки Google Benchmark)
+ */
+
+using namespace RansacNamespace;
+
+namespace {
+
+    /// Количество вызовов operator new (контейнеры std, mrpt). Буферы cv::Mat выделяются через cv::fastMalloc.
+    std::atomic<uint64_t> allocations{0};
+
+    /// Параметры bird преобразования по умолчанию (кадр 1280x720).
+    const std::vector<int> base_bird = {381, 350, 557, 350, 0, 531, 906, 533, 608, 371};
+    const std::vector<int> base_hsv = {21, 76, 13, 48, 110, 28};
+
+    /// Параметры bird преобразования для кадра высотой height.
+    std::vector<int> scaled_bird(int height) {
+        double s = height / 720.0;
+        std::vector<int> params;
+        for (int p : base_bird)
+            params.push_back(static_cast<int>(p * s));
+        return params;
+    }
+
+    /// Цвет разметки внутри диапазона parametersHSV по умолчанию (HLS 30, 95, 20).
+    cv::Scalar paint_color() {
+        cv::Mat hls(1, 1, CV_8UC3, cv::Scalar(30, 95, 20));
+        cv::Mat bgr;
+        cv::cvtColor(hls, bgr, cv::COLOR_HLS2BGR);
+        cv::Vec3b c = bgr.at<cv::Vec3b>(0, 0);
+        return {static_cast<double>(c[0]), static_cast<double>(c[1]), static_cast<double>(c[2])};
+    }
+
+    /**
+     * Синтетическое изображение дороги сверху: 4 линии разметки (средние - прерывистые),
+     * гауссов шум с СКО noise и clutter ложных пятен цвета разметки.
+     */
+    cv::Mat make_road(int width, int height, double noise, int clutter, uint64_t seed) {
+        cv::Mat img(height, width, CV_8UC3, cv::Scalar(60, 60, 60));
+        cv::Scalar paint = paint_color();
+        int line_w = std::max(4, width / 120);
+        int dash = std::max(1, height / 8);
+
+        for (int k = 0; k < 4; k++) {
+            int x0 = static_cast<int>(width * (0.125 + 0.25 * k));
+            bool dashed = (k == 1) || (k == 2);
+            for (int y = 0; y < height; y += dashed ? 2 * dash : height) {
+                int y1 = std::min(height, y + (dashed ? dash : height));
+                cv::rectangle(img, cv::Point(x0 - line_w / 2, y), cv::Point(x0 + line_w / 2, y1), paint, cv::FILLED);
+            }
+        }
+
+        cv::RNG rng(seed);
+        for (int i = 0; i < clutter; i++) {
+            cv::Point c(rng.uniform(0, width), rng.uniform(0, height));
+            cv::circle(img, c, rng.uniform(2, 12), paint, cv::FILLED);
+        }
+
+        if (noise > 0) {
+            cv::Mat img16, n(img.size(), CV_16SC3);
+            cv::randn(n, cv::Scalar::all(0), cv::Scalar::all(noise));
+            img.convertTo(img16, CV_16SC3);
+            img16 = img16 + n;
+            img16.convertTo(img, CV_8UC3);
+        }
+        return img;
+    }
+
+    /// Точки на 4 вертикальных линиях изображения 608x371 с разбросом ±1 пиксель и долей выбросов outliers.
+    std::vector<cv::Point> make_line_points(size_t count, double outliers, uint64_t seed) {
+        cv::RNG rng(seed);
+        std::vector<cv::Point> points;
+        points.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            if (rng.uniform(0.0, 1.0) < outliers) {
+                points.emplace_back(rng.uniform(0, 608), rng.uniform(0, 371));
+            } else {
+                int k = rng.uniform(0, 4);
+                int y = rng.uniform(0, 371);
+                points.emplace_back(76 + 152 * k + rng.uniform(-1, 2), y);
+            }
+        }
+        return points;
+    }
+
+    /// Точки на параболе x = a*y^2 + b*y + c с гауссовым шумом по x.
+    std::vector<cv::Point> make_curve_points(size_t count, double noise, uint64_t seed) {
+        cv::RNG rng(seed);
+        std::vector<cv::Point> points;
+        points.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            double y = rng.uniform(0.0, 371.0);
+            double x = 0.0002 * y * y - 0.05 * y + 200 + rng.gaussian(noise);
+            points.emplace_back(static_cast<int>(x), static_cast<int>(y));
+        }
+        return points;
+    }
+
+    /**
+     * Сравнение найденных линий с истинными по положению у нижнего края и в середине изображения сверху.
+     * Истинная линия найдена, если ближайшая найденная отличается меньше max_error пикселей.
+     */
+    void score_lines(const lane_polys& found, const lane_polys& truth, int height, double max_error,
+                     double& error_sum, size_t& matched) {
+        double rows[2] = {static_cast<double>(height), height / 2.0};
+        for (auto &t : truth) {
+            double best = max_error;
+            for (auto &l : found) {
+                if (!l.found())
+                    continue;
+                double e = 0.5 * (std::abs(l.x(rows[0]) - t.x(rows[0])) + std::abs(l.x(rows[1]) - t.x(rows[1])));
+                best = std::min(best, e);
+            }
+            if (best < max_error) {
+                error_sum += best;
+                matched++;
+            }
+        }
+    }
+
+    /// Полиномы 4 вертикальных линий изображения 608x371.
+    lane_polys make_polylines() {
+        lane_polys lines{};
+        lines.reset(4);
+        for (size_t k = 0; k < 4; k++)
+            lines[k] = {0, 0, static_cast<float>(76 + 152 * k)};
+        return lines;
+    }
+
+}
+
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+static void BM_warpImage(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    int width = height * 16 / 9;
+    std::vector<int> params = scaled_bird(height);
+    std::vector<cv::Mat> matrix = Bird_view::return_bird_matrix(params);
+    cv::Mat frame = make_road(width, height, 8, 50, 1);
+
+    cv::Mat bird;
+
+    for (auto _ : state) {
+        Bird_view::warpImage(frame, frame, matrix, params, bird, 'n');
+        benchmark::DoNotOptimize(bird.data);
+    }
+    state.SetItemsProcessed(state.iterations() * params[8] * params[9]);
+}
+BENCHMARK(BM_warpImage)->ArgName("height")->Arg(720)->Arg(1080)->Arg(2160)->Unit(benchmark::kMillisecond);
+
+
+static void BM_return_hsv(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<int> hsv_params = base_hsv;
+    cv::Mat bird = make_road(params[9], params[8], static_cast<double>(state.range(1)), 50, 2);
+    cv::Mat hls, mask;
+
+    for (auto _ : state) {
+        hsv::return_hsv(bird, hsv_params, hls, mask);
+        benchmark::DoNotOptimize(mask.data);
+    }
+    state.SetItemsProcessed(state.iterations() * bird.rows * bird.cols);
+}
+BENCHMARK(BM_return_hsv)->ArgNames({"height", "noise"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 8, 24}})->Unit(benchmark::kMillisecond);
+
+
+/**
+ * Маска по таблице YUV на том же изображении, что BM_return_hsv (в I420, без перевода в BGR и HLS).
+ * agree% - доля пикселей, совпадающих с маской return_hsv.
+ */
+static void BM_threshold_yuv(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<int> hsv_params = base_hsv;
+    // YUV 4:2:0 - чётные размеры.
+    cv::Mat bird = make_road(params[9] & ~1, params[8] & ~1, static_cast<double>(state.range(1)), 50, 2);
+    cv::Mat yuv, luma, chroma, mask;
+    cv::cvtColor(bird, yuv, cv::COLOR_BGR2YUV_I420);
+    hsv::yuv_lut lut;
+    lut.build(hsv_params);
+    hsv::yuv_planes(yuv, frame_format::i420, luma, chroma);
+    const std::vector<cv::Range> whole_image;
+
+    for (auto _ : state) {
+        hsv::threshold_yuv(luma, chroma, lut, whole_image, mask);
+        benchmark::DoNotOptimize(mask.data);
+    }
+    state.SetItemsProcessed(state.iterations() * bird.rows * bird.cols);
+
+    cv::Mat hls, reference, diff;
+    hsv::return_hsv(bird, hsv_params, hls, reference);
+    cv::compare(mask, reference, diff, cv::CMP_EQ);
+    state.counters["agree%"] = 100.0 * cv::countNonZero(diff) / static_cast<double>(diff.total());
+}
+BENCHMARK(BM_threshold_yuv)->ArgNames({"height", "noise"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 8, 24}})->Unit(benchmark::kMillisecond);
+
+
+static void BM_filtered_img(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<int> hsv_params = base_hsv;
+    cv::Mat bird = make_road(params[9], params[8], static_cast<double>(state.range(1)),
+                             static_cast<int>(state.range(2)), 3);
+    cv::Mat hls, mask;
+    hsv::return_hsv(bird, hsv_params, hls, mask);
+    hsv::filter_buffers buffers;
+    std::vector<std::vector<cv::Point>> contours;
+    point_buffer coord;
+    size_t points = 0;
+
+    for (auto _ : state) {
+        hsv::filtered_img(mask, contours, coord, buffers);
+        points = coord.size();
+        benchmark::DoNotOptimize(coord.rows.data());
+    }
+    state.counters["points"] = static_cast<double>(points);
+}
+BENCHMARK(BM_filtered_img)->ArgNames({"height", "noise", "clutter"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 24}, {0, 200}})->Unit(benchmark::kMillisecond);
+
+/// Точки по строкам маски после filtered_img(): количество точек не растёт с разрешением сверх бюджета.
+static void BM_scan_line_points(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<int> hsv_params = base_hsv;
+    cv::Mat bird = make_road(params[9], params[8], 0, 200, 3);
+    cv::Mat hls, mask;
+    hsv::return_hsv(bird, hsv_params, hls, mask);
+    hsv::filter_buffers buffers;
+    std::vector<std::vector<cv::Point>> contours;
+    point_buffer coord;
+    hsv::filtered_img(mask, contours, coord, buffers);
+    cv::Mat labels;
+
+    for (auto _ : state) {
+        scan_line_points(mask, contours, static_cast<int>(state.range(1)), 1000, labels, coord);
+        benchmark::DoNotOptimize(coord.rows.data());
+    }
+    state.counters["points"] = static_cast<double>(coord.size());
+}
+BENCHMARK(BM_scan_line_points)->ArgNames({"height", "step"})
+        ->ArgsProduct({{720, 1080, 2160}, {1, 4}})->Unit(benchmark::kMicrosecond);
+
+
+static void BM_RANSACLines(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    double outliers = static_cast<double>(state.range(1)) / 100.0;
+    point_buffer points;
+    points.append(make_line_points(count, outliers, 4));
+    std::vector<LanePoly> lines;
+
+    for (auto _ : state) {
+        RANSACLines(points, 20, 5, lines);
+        benchmark::DoNotOptimize(lines.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_RANSACLines)->ArgNames({"points", "outliers%"})
+        ->ArgsProduct({{250, 1000, 4000, 16000}, {0, 20, 50}})->Unit(benchmark::kMillisecond);
+
+
+static void BM_find_x_y(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(720);
+    std::vector<int> hsv_params = base_hsv;
+    cv::Mat bird = make_road(params[9], params[8], 8, static_cast<int>(state.range(0)), 5);
+    cv::Mat hls, mask;
+    hsv::return_hsv(bird, hsv_params, hls, mask);
+    hsv::filter_buffers buffers;
+    std::vector<std::vector<cv::Point>> contours;
+    point_buffer coord;
+    hsv::filtered_img(mask, contours, coord, buffers);
+    lane_polys lines = make_polylines();
+
+    std::vector<point_buffer> result_coord;
+
+    for (auto _ : state) {
+        find_x_y(lines, contours, 20, result_coord);
+        benchmark::DoNotOptimize(result_coord.data());
+    }
+    state.counters["contours"] = static_cast<double>(contours.size());
+}
+BENCHMARK(BM_find_x_y)->ArgName("clutter")->Arg(0)->Arg(100)->Arg(400)->Unit(benchmark::kMicrosecond);
+
+
+/// Штрихи и разрывы вдоль 4 линий по маске (O(строк) на линию).
+static void BM_mask_profile(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<int> hsv_params = base_hsv;
+    cv::Mat bird = make_road(params[9], params[8], 8, 100, 5);
+    cv::Mat hls, mask;
+    hsv::return_hsv(bird, hsv_params, hls, mask);
+    lane_polys lines{};
+    lines.reset(4);
+    for (size_t k = 0; k < 4; k++)
+        lines[k] = {0, 0, static_cast<float>(params[9] * (0.125 + 0.25 * static_cast<double>(k)))};
+    dash_profile profile;
+
+    for (auto _ : state) {
+        for (auto &line : lines) {
+            mask_profile(mask, line, 5, profile);
+            benchmark::DoNotOptimize(profile);
+        }
+    }
+    // Сплошная (левая) и прерывистая линии make_road().
+    mask_profile(mask, lines[0], 5, profile);
+    state.counters["duty_solid"] = profile.duty();
+    mask_profile(mask, lines[1], 5, profile);
+    state.counters["duty_dashed"] = profile.duty();
+}
+BENCHMARK(BM_mask_profile)->ArgName("height")->Arg(720)->Arg(2160)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_x_y_to_polynom(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    double noise = static_cast<double>(state.range(1));
+    std::vector<point_buffer> coord_for_lines(4);
+    for (uint64_t k = 0; k < 4; k++)
+        coord_for_lines[k].append(make_curve_points(count, noise, 6 + k));
+    lane_polys lines{};
+
+    for (auto _ : state) {
+        x_y_to_polynom(coord_for_lines, lines);
+        benchmark::DoNotOptimize(lines);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(4 * count));
+}
+BENCHMARK(BM_x_y_to_polynom)->ArgNames({"points", "noise"})
+        ->ArgsProduct({{100, 1000, 10000}, {0, 3}})->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * fit_polynomial: фиксированный размер системы (степень известна при компиляции)
+ * против Eigen::Dynamic (степень во время выполнения) на одних и тех же точках.
+ */
+template <int Coeffs>
+static void BM_fit_polynomial(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    point_buffer points;
+    points.append(make_curve_points(count, 3, 6));
+    Eigen::Matrix<double, Coeffs, 1> coeffs;
+    coeffs.resize(3);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fit_polynomial<Coeffs>(points, coeffs));
+        benchmark::DoNotOptimize(coeffs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK_TEMPLATE(BM_fit_polynomial, 3)->Name("BM_fit_polynomial/fixed")->ArgName("points")
+        ->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_fit_polynomial, Eigen::Dynamic)->Name("BM_fit_polynomial/dynamic")->ArgName("points")
+        ->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_normalizeData(benchmark::State& state) {
+    size_t containers = static_cast<size_t>(state.range(0));
+    size_t stripes = 4;
+    container cont(containers, stripes, 608);
+    cv::RNG rng(7);
+    lane_polys lines = make_polylines();
+    stripe_counters I1{}, I2{};
+    I2.fill(999);
+    stripe_flags buff{};
+    buff.fill(true);
+
+    for (auto _ : state) {
+        // Каждый третий кадр одна из линий пропадает.
+        lane_polys current = lines;
+        if (rng.uniform(0, 3) == 0)
+            current[static_cast<size_t>(rng.uniform(0, 4))] = {0, 0, 0};
+        container::add_to_container(current, cont.contain);
+        container::normalizeData(cont.contain, I1, buff, I2, 9);
+        benchmark::DoNotOptimize(cont.contain.back());
+    }
+}
+BENCHMARK(BM_normalizeData)->ArgName("containers")->Arg(10)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_get_three_point_vector(benchmark::State& state) {
+    std::vector<int> params = scaled_bird(static_cast<int>(state.range(0)));
+    std::vector<cv::Mat> matrix = Bird_view::return_bird_matrix(params);
+    settings init;
+    lane_polys lines{};
+    lines.reset(4);
+    for (size_t k = 0; k < 4; k++)
+        lines[k] = {0, 0, static_cast<float>(params[9] * (0.125 + 0.25 * static_cast<double>(k)))};
+    std::vector<double> distance = {0, 0};
+    cv::Size size(params[9], params[8]);
+    std::vector<std::vector<cv::Point2d>> points;
+
+    for (auto _ : state) {
+        get_three_point_vector(lines, size, matrix[1], init.transformationMatrix, distance, points);
+        benchmark::DoNotOptimize(points.data());
+    }
+}
+BENCHMARK(BM_get_three_point_vector)->ArgName("height")->Arg(720)->Arg(2160)->Unit(benchmark::kMicrosecond);
+
+
+/**
+ * Полная обработка кадра LaneDetector::process на синтетическом видео.
+ * Счётчик allocs/frame - вызовы operator new на кадр после прогрева (без данных cv::Mat).
+ */
+static void BM_LaneDetector_process(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    settings init;
+    synthetic_params params;
+    params.width = height * 16 / 9;
+    params.height = height;
+    synthetic_road road(init, params);
+    init.parametersBird = road.bird_parameters();
+
+    std::vector<cv::Mat> frames(32);
+    lane_polys truth{};
+    std::vector<bool> solid;
+    for (size_t i = 0; i < frames.size(); i++)
+        road.render(i, frames[i], truth, solid);
+
+    LaneDetector detector(init);
+    LaneDetector::Result result;
+    for (size_t i = 0; i < 2 * frames.size(); i++)
+        detector.process(frames[i % frames.size()], result); // Прогрев: буферы достигают рабочего размера.
+
+    size_t i = 0;
+    uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        detector.process(frames[i++ % frames.size()], result);
+        benchmark::DoNotOptimize(result.lines);
+    }
+    uint64_t allocs = allocations.load(std::memory_order_relaxed) - before;
+    state.counters["allocs/frame"] = static_cast<double>(allocs) / static_cast<double>(state.iterations());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LaneDetector_process)->ArgName("height")->Arg(720)->Arg(1080)->Arg(2160)->Unit(benchmark::kMillisecond);
+
+
+/**
+ * Прогоняет детектор по синтетическим кадрам и считает точность относительно истинных линий:
+ * err_px - средняя ошибка найденных линий, found% - доля найденных истинных линий.
+ *
+ * @param configure - изменяет параметры детектора после выбора размера кадра.
+ * @param format - формат кадров, передаваемых детектору (input_format задаёт configure).
+ */
+template <typename Configure>
+static void run_scored(benchmark::State& state, int height, Configure configure, frame_format format = frame_format::bgr) {
+    settings init;
+    synthetic_params params;
+    params.width = height * 16 / 9;
+    params.height = height;
+    synthetic_road road(init, params);
+    init.parametersBird = road.bird_parameters();
+    configure(init);
+
+    std::vector<cv::Mat> frames(32);
+    std::vector<lane_polys> truth(frames.size());
+    std::vector<bool> solid;
+    for (size_t i = 0; i < frames.size(); i++) {
+        road.render(i, frames[i], truth[i], solid);
+        if (format == frame_format::i420)
+            cv::cvtColor(frames[i], frames[i], cv::COLOR_BGR2YUV_I420);
+    }
+
+    LaneDetector detector(init);
+    LaneDetector::Result result;
+    for (size_t i = 0; i < frames.size(); i++)
+        detector.process(frames[i], result);
+
+    size_t i = 0, matched = 0, total = 0;
+    double error_sum = 0;
+    for (auto _ : state) {
+        size_t k = i++ % frames.size();
+        detector.process(frames[k], result);
+        score_lines(result.lines, truth[k], init.parametersBird[8], init.width_line_search, error_sum, matched);
+        total += truth[k].size();
+    }
+    state.counters["err_px"] = matched > 0 ? error_sum / static_cast<double>(matched) : 0.0;
+    state.counters["found%"] = total > 0 ? 100.0 * static_cast<double>(matched) / static_cast<double>(total) : 0.0;
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Режим пирамиды: скорость и точность в зависимости от масштаба грубого поиска (scale% = 100 - без пирамиды).
+ */
+static void BM_LaneDetector_pyramid(benchmark::State& state) {
+    double scale = static_cast<double>(state.range(1)) / 100.0;
+    run_scored(state, static_cast<int>(state.range(0)), [scale](settings& init) { init.pyramid_scale = scale; });
+}
+BENCHMARK(BM_LaneDetector_pyramid)->ArgNames({"height", "scale%"})
+        ->ArgsProduct({{720, 1080, 2160}, {100, 50, 25}})->Unit(benchmark::kMillisecond);
+
+/**
+ * Слежение: скорость и точность в зависимости от ширины полос вокруг линий предыдущего кадра
+ * (margin = 0 - без слежения). Синтетические кадры повторяются по кругу, скачок при повторе
+ * отрабатывает повторный поиск по всему кадру.
+ */
+static void BM_LaneDetector_tracking(benchmark::State& state) {
+    int margin = static_cast<int>(state.range(1));
+    run_scored(state, static_cast<int>(state.range(0)), [margin](settings& init) { init.roi_margin = margin; });
+}
+BENCHMARK(BM_LaneDetector_tracking)->ArgNames({"height", "margin"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 20, 40}})->Unit(benchmark::kMillisecond);
+
+/// Кадры I420 без перевода в BGR против тех же кадров BGR (yuv = 0).
+static void BM_LaneDetector_yuv(benchmark::State& state) {
+    frame_format format = state.range(1) != 0 ? frame_format::i420 : frame_format::bgr;
+    run_scored(state, static_cast<int>(state.range(0)), [format](settings& init) {
+        init.input_format = format == frame_format::i420 ? "i420" : "bgr";
+    }, format);
+}
+BENCHMARK(BM_LaneDetector_yuv)->ArgNames({"height", "yuv"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+/// Разреженный front end (фильтр в кадре камеры, проекция пятен) против bird преобразования всего кадра (sparse = 0).
+static void BM_LaneDetector_sparse(benchmark::State& state) {
+    int sparse = static_cast<int>(state.range(1));
+    run_scored(state, static_cast<int>(state.range(0)), [sparse](settings& init) { init.sparse_front = sparse; });
+}
+BENCHMARK(BM_LaneDetector_sparse)->ArgNames({"height", "sparse"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+/// Точки для RANSAC по строкам маски с шагом step (step = 0 - точки контуров).
+static void BM_LaneDetector_scan(benchmark::State& state) {
+    int step = static_cast<int>(state.range(1));
+    run_scored(state, static_cast<int>(state.range(0)), [step](settings& init) { init.scan_step = step; });
+}
+BENCHMARK(BM_LaneDetector_scan)->ArgNames({"height", "step"})
+        ->ArgsProduct({{720, 1080, 2160}, {0, 2, 4, 8}})->Unit(benchmark::kMillisecond);
+
+/**
+ * Неподвижная сцена (один кадр с шумом камеры): повтор результата по сигнатуре трапеции
+ * (threshold = 0 - каждый кадр обрабатывается). reused% - доля кадров с повтором результата.
+ */
+static void BM_LaneDetector_static(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    settings init;
+    synthetic_params params;
+    params.width = height * 16 / 9;
+    params.height = height;
+    // Сцена не движется, от кадра к кадру меняется только шум камеры.
+    params.speed = 0;
+    params.sway = 0;
+    params.curvature = 0;
+    params.shadows = 0;
+    params.clutter = 0;
+    synthetic_road road(init, params);
+    init.parametersBird = road.bird_parameters();
+    init.static_threshold = static_cast<double>(state.range(1));
+
+    std::vector<cv::Mat> frames(8);
+    lane_polys truth{};
+    std::vector<bool> solid;
+    for (size_t i = 0; i < frames.size(); i++)
+        road.render(i, frames[i], truth, solid);
+
+    LaneDetector detector(init);
+    LaneDetector::Result result;
+    size_t i = 0;
+    for (auto _ : state) {
+        detector.process(frames[i++ % frames.size()], result);
+        benchmark::DoNotOptimize(result.lines);
+    }
+    state.counters["reused%"] = 100.0 * static_cast<double>(detector.reused_frames()) /
+                                static_cast<double>(state.iterations());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LaneDetector_static)->ArgNames({"height", "threshold"})
+        ->ArgsProduct({{720, 2160}, {0, 4}})->Unit(benchmark::kMillisecond);
+
+/**
+ * Передача внешнего буфера детектору: заголовок cv::Mat на память буфера (copy = 0)
+ * против копирования кадра в cv::Mat (copy = 1). Буферы - кадры synthetic_source.
+ */
+static void BM_external_frame(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    bool copy = state.range(1) != 0;
+    settings init;
+    synthetic_params params;
+    params.width = height * 16 / 9;
+    params.height = height;
+    synthetic_source producer(init, params, 1, frame_format::nv12, 1);
+    external_frame produced;
+    producer.next(produced);
+
+    external_source source(4);
+    external_frame input;
+    cv::Mat wrapped, frame;
+    for (auto _ : state) {
+        external_frame pushed = produced;
+        pushed.release = nullptr;
+        source.push(pushed);
+        source.next(input);
+        wrap_frame(input, wrapped);
+        if (copy)
+            wrapped.copyTo(frame);
+        else
+            frame = wrapped;
+        benchmark::DoNotOptimize(frame.data);
+        release_frame(input);
+    }
+    release_frame(produced);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_external_frame)->ArgNames({"height", "copy"})
+        ->ArgsProduct({{720, 2160}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+#include "../../include/Ransac.h"
+
+#include <cstdio>
+
+/**
+ * Офлайн обработка длинного видео по частям во всех ядрах (process_offline()).
+ *
+ * Использование:
+ *   lane_offline <конфигурация> [видео] [--chunks N] [--warmup N] [--frames N] [--out файл] [--format jsonl|csv|bin]
+ *
+ * --chunks - количество частей и потоков (по умолчанию - количество ядер).
+ * --warmup - кадров перекрытия перед каждой частью для накопления сглаживания (по умолчанию 30).
+ * --frames - обработать не больше N кадров с начала видео.
+ * --out, --format - файл и формат результатов по кадрам (по умолчанию stdout и telemetry_format из конфигурации).
+ * Записи идут по порядку кадров, как в телеметрии при последовательной обработке.
+ */
+int main(int argc, char** argv) {
+    std::vector<std::string> positional;
+    RansacNamespace::offline_options options;
+    options.chunks = std::max(1u, std::thread::hardware_concurrency());
+    std::string out_path;
+    std::string format;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if ((arg == "--chunks") && has_value)
+            options.chunks = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if ((arg == "--warmup") && has_value)
+            options.warmup = std::stoul(argv[++i]);
+        else if ((arg == "--frames") && has_value)
+            options.max_frames = std::stoul(argv[++i]);
+        else if ((arg == "--out") && has_value)
+            out_path = argv[++i];
+        else if ((arg == "--format") && has_value)
+            format = argv[++i];
+        else
+            positional.push_back(arg);
+    }
+    if (positional.empty()) {
+        std::cout << "Использование: lane_offline <конфигурация> [видео] [--chunks N] [--warmup N] [--frames N] "
+                     "[--out файл] [--format jsonl|csv|bin]" << std::endl;
+        return 1;
+    }
+
+    RansacNamespace::settings init;
+    if (!init.load(positional[0]))
+        return 1;
+    if (positional.size() > 1)
+        init.video_name = positional[1];
+    auto encoder = RansacNamespace::telemetry_encoder::create(format.empty() ? init.telemetry_format : format);
+    if (!encoder) {
+        std::cout << "Ошибка: неизвестный формат " << format << std::endl;
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (!out_path.empty()) {
+        out = fopen(out_path.c_str(), encoder->binary() ? "wb" : "w");
+        if (out == nullptr) {
+            std::cout << "Ошибка: не удалось открыть " << out_path << " для записи" << std::endl;
+            return 1;
+        }
+    }
+    std::string text;
+    encoder->header(text);
+    fwrite(text.data(), 1, text.size(), out);
+
+    RansacNamespace::offline_stats stats;
+    bool ok = RansacNamespace::process_offline(init, options, [&](const RansacNamespace::frame_record& rec) {
+        text.clear();
+        encoder->encode(rec, text);
+        fwrite(text.data(), 1, text.size(), out);
+    }, stats);
+    if (out != stdout)
+        fclose(out);
+
+    // Статистика - в stderr, чтобы не смешиваться с результатами в stdout.
+    std::cerr << "Кадров: " << stats.frames << ", частей: " << stats.chunks << ", кадров перекрытия: "
+              << stats.warmup_frames << ", время: " << stats.seconds << " с, "
+              << (stats.seconds > 0 ? static_cast<double>(stats.frames) / stats.seconds : 0.0) << " кадров/с" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+#include "../../include/Ransac.h"
+
+#include <sstream>
+
+/**
+ * Проверка точности и скорости детекции на наборе клипов по эталонным результатам.
+ *
+ * Использование:
+ *   lane_regress record  <каталог эталонов> <конфигурация клипа>... [--frames N]
+ *   lane_regress compare <каталог эталонов> <конфигурация клипа>... [--frames N]
+ *                        [--tol-a A] [--tol-b B] [--tol-c C] [--tol-dist D]
+ *
+ * Клип задаётся файлом конфигурации (видео, input_format и параметры детекции), например созданным lane_synth.
+ * Эталон клипа - <каталог>/<имя конфигурации>.golden.csv: по строке на кадр со сглаженными
+ * полиномами, типами линий и расстояниями, в заголовке - производительность при записи.
+ * Кадр считается изменённым, если хотя бы одно значение отличается больше допуска
+ * или изменился тип линии. compare возвращает 2, если изменённые кадры есть.
+ */
+
+namespace {
+
+    /// Результаты одного кадра, сравниваемые с эталоном.
+    struct frame_values {
+        double left = 0;
+        double right = 0;
+        std::vector<int> solid;
+        std::vector<std::array<double, 3>> coefs;
+    };
+
+    struct clip_run {
+        std::vector<frame_values> frames;
+        /// Кадров в секунду (только LaneDetector::process, без декодирования)
+        double fps = 0;
+    };
+
+    struct tolerance {
+        double a = 1e-6;
+        double b = 1e-3;
+        double c = 1.0;
+        double dist = 0.05;
+    };
+
+    /// Кадров, декодируемых заранее перед обработкой (память - decode_batch кадров независимо от длины клипа).
+    constexpr size_t decode_batch = 64;
+
+    /**
+     * Обрабатывает клип и собирает результаты по кадрам. Кадры читаются через video_source в формате
+     * input_format клипа (YUV клипы - без перевода в BGR, как в lane_offline) и декодируются пачками
+     * по decode_batch в переиспользуемые буферы пула, время декодирования в скорость обработки не входит.
+     */
+    bool run_clip(const RansacNamespace::settings& init, size_t max_frames, clip_run& run) {
+        RansacNamespace::frame_format format = RansacNamespace::frame_format::bgr;
+        RansacNamespace::parse_frame_format(init.input_format, format);
+        RansacNamespace::video_source source(init.video_name, format, decode_batch);
+        if (!source.is_open())
+            return false;
+        std::vector<RansacNamespace::external_frame> batch(decode_batch);
+        std::vector<cv::Mat> frames(decode_batch);
+
+        RansacNamespace::LaneDetector detector(init);
+        RansacNamespace::LaneDetector::Result result;
+        std::chrono::steady_clock::duration busy{};
+        size_t processed = 0;
+
+        while (processed < max_frames) {
+            size_t n = 0;
+            while ((n < batch.size()) && (processed + n < max_frames) && source.next(batch[n])) {
+                if (!RansacNamespace::wrap_frame(batch[n], frames[n])) {
+                    for (size_t i = 0; i <= n; i++)
+                        RansacNamespace::release_frame(batch[i]);
+                    return false;
+                }
+                n++;
+            }
+            if (n == 0)
+                break;
+
+            for (size_t i = 0; i < n; i++) {
+                auto begin = std::chrono::steady_clock::now();
+                detector.process(frames[i], result);
+                busy += std::chrono::steady_clock::now() - begin;
+                frames[i].release();
+                RansacNamespace::release_frame(batch[i]);
+
+                frame_values v;
+                v.left = result.left_right_distance[0];
+                v.right = result.left_right_distance[1];
+                for (size_t k = 0; k < result.smoothed.size(); k++) {
+                    v.solid.push_back((k < result.types.size()) && result.types[k] ? 1 : 0);
+                    v.coefs.push_back({result.smoothed[k].a, result.smoothed[k].b, result.smoothed[k].c});
+                }
+                run.frames.push_back(v);
+            }
+            processed += n;
+            if (n < batch.size())
+                break;
+        }
+        double seconds = std::chrono::duration<double>(busy).count();
+        run.fps = seconds > 0 ? static_cast<double>(processed) / seconds : 0;
+        return true;
+    }
+
+    bool write_golden(const std::string& path, const clip_run& run) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            std::cout << "Ошибка: не удалось открыть " << path << " для записи" << std::endl;
+            return false;
+        }
+        out << "# fps=" << run.fps << "\n" << std::setprecision(17);
+        for (size_t i = 0; i < run.frames.size(); i++) {
+            const frame_values &v = run.frames[i];
+            out << i << ',' << v.left << ',' << v.right;
+            for (size_t k = 0; k < v.coefs.size(); k++)
+                out << ',' << v.solid[k] << ',' << v.coefs[k][0] << ',' << v.coefs[k][1] << ',' << v.coefs[k][2];
+            out << '\n';
+        }
+        return true;
+    }
+
+    bool read_golden(const std::string& path, clip_run& run) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cout << "Ошибка: нет эталона " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.rfind("# fps=", 0) == 0) {
+                run.fps = std::stod(line.substr(6));
+                continue;
+            }
+            std::vector<double> fields;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, ','))
+                fields.push_back(std::stod(field));
+            if ((fields.size() < 3) || ((fields.size() - 3) % 4 != 0)) {
+                std::cout << "Ошибка: неверная строка эталона " << path << ": " << line << std::endl;
+                return false;
+            }
+            frame_values v;
+            v.left = fields[1];
+            v.right = fields[2];
+            for (size_t k = 3; k < fields.size(); k += 4) {
+                v.solid.push_back(static_cast<int>(fields[k]));
+                v.coefs.push_back({fields[k + 1], fields[k + 2], fields[k + 3]});
+            }
+            run.frames.push_back(v);
+        }
+        return true;
+    }
+
+    bool frame_changed(const frame_values& golden, const frame_values& now, const tolerance& tol) {
+        if ((std::abs(golden.left - now.left) > tol.dist) || (std::abs(golden.right - now.right) > tol.dist))
+            return true;
+        if ((golden.solid != now.solid) || (golden.coefs.size() != now.coefs.size()))
+            return true;
+        for (size_t k = 0; k < golden.coefs.size(); k++) {
+            if ((std::abs(golden.coefs[k][0] - now.coefs[k][0]) > tol.a) ||
+                (std::abs(golden.coefs[k][1] - now.coefs[k][1]) > tol.b) ||
+                (std::abs(golden.coefs[k][2] - now.coefs[k][2]) > tol.c))
+                return true;
+        }
+        return false;
+    }
+
+    std::string golden_path(const std::string& dir, const std::string& config) {
+        std::string name = config.substr(config.find_last_of('/') + 1);
+        return dir + "/" + name + ".golden.csv";
+    }
+
+}
+
+
+int main(int argc, char** argv) {
+    std::vector<std::string> positional;
+    size_t max_frames = SIZE_MAX;
+    tolerance tol;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if ((arg == "--frames") && has_value)
+            max_frames = std::stoul(argv[++i]);
+        else if ((arg == "--tol-a") && has_value)
+            tol.a = std::stod(argv[++i]);
+        else if ((arg == "--tol-b") && has_value)
+            tol.b = std::stod(argv[++i]);
+        else if ((arg == "--tol-c") && has_value)
+            tol.c = std::stod(argv[++i]);
+        else if ((arg == "--tol-dist") && has_value)
+            tol.dist = std::stod(argv[++i]);
+        else
+            positional.push_back(arg);
+    }
+    if ((positional.size() < 3) || ((positional[0] != "record") && (positional[0] != "compare"))) {
+        std::cout << "Использование: lane_regress record|compare <каталог эталонов> <конфигурация клипа>... "
+                     "[--frames N] [--tol-a A] [--tol-b B] [--tol-c C] [--tol-dist D]" << std::endl;
+        return 1;
+    }
+    bool record = positional[0] == "record";
+    const std::string &dir = positional[1];
+
+    size_t total_frames = 0, changed_frames = 0;
+    double golden_time = 0, current_time = 0;
+
+    std::cout << std::left << std::setw(32) << "clip" << std::right << std::setw(8) << "frames"
+              << std::setw(10) << "changed" << std::setw(12) << "fps gold" << std::setw(12) << "fps now" << "\n";
+    for (size_t c = 2; c < positional.size(); c++) {
+        const std::string &config = positional[c];
+        RansacNamespace::settings init;
+        if (!init.load(config))
+            return 1;
+
+        clip_run run;
+        if (!run_clip(init, max_frames, run))
+            return 1;
+
+        if (record) {
+            if (!write_golden(golden_path(dir, config), run))
+                return 1;
+            std::cout << std::left << std::setw(32) << config << std::right << std::setw(8) << run.frames.size()
+                      << std::setw(10) << "-" << std::setw(12) << "-" << std::setw(12) << run.fps << "\n";
+            continue;
+        }
+
+        clip_run golden;
+        if (!read_golden(golden_path(dir, config), golden))
+            return 1;
+
+        // Кадры, отсутствующие в одном из прогонов, тоже считаются изменёнными.
+        size_t frames = std::max(golden.frames.size(), run.frames.size());
+        size_t changed = 0;
+        for (size_t i = 0; i < frames; i++) {
+            if ((i >= golden.frames.size()) || (i >= run.frames.size()) ||
+                frame_changed(golden.frames[i], run.frames[i], tol))
+                changed++;
+        }
+        total_frames += frames;
+        changed_frames += changed;
+        // Суммарное время обработки всех клипов по эталонной и текущей скорости.
+        if ((golden.fps > 0) && (run.fps > 0)) {
+            golden_time += static_cast<double>(run.frames.size()) / golden.fps;
+            current_time += static_cast<double>(run.frames.size()) / run.fps;
+        }
+
+        std::cout << std::left << std::setw(32) << config << std::right << std::setw(8) << frames
+                  << std::setw(10) << changed << std::setw(12) << golden.fps << std::setw(12) << run.fps << "\n";
+    }
+
+    if (record) {
+        std::cout << "Эталоны записаны в " << dir << std::endl;
+        return 0;
+    }
+
+    double faster = current_time > 0 ? (golden_time / current_time - 1) * 100 : 0;
+    std::cout << "\nИтог: " << std::fixed << std::setprecision(1) << std::abs(faster) << "% "
+              << (faster >= 0 ? "быстрее" : "медленнее") << ", " << changed_frames << " из " << total_frames
+              << " кадров изменились сверх допуска" << std::endl;
+    return changed_frames > 0 ? 2 : 0;
+}
@@ -0,0 +1,120 @@
+#include "../../include/Ransac.h"
+
+/**
+ * Генератор синтетического видео с известной разметкой.
+ *
+ * Использование: lane_synth [файл конфигурации] <выход> [параметры]
+ *   --frames N        количество кадров (300)
+ *   --size WxH        размер кадра (1280x720, до 3840x2160)
+ *   --noise S         СКО шума
+ *   --shadows N       количество теней
+ *   --clutter N       количество ложных пятен на кадре
+ *   --seed N          начальное значение генератора
+ *   --fps F           частота кадров видео (30)
+ *   --raw             поток кадров BGR24 без заголовков вместо видео
+ *                     (ffmpeg -f rawvideo -pix_fmt bgr24 -s WxH -i выход)
+ *
+ * Рядом с выходом записываются:
+ *   <выход>.truth.csv - истинные полиномы: frame,lane,solid,a,b,c (координаты изображения сверху)
+ *   <выход>.yaml      - конфигурация для RANSAC2 с видео и масштабированными parametersBird
+ */
+int main(int argc, char** argv) {
+    std::string config_path = "../data/config.yaml";
+    std::string out_path;
+    RansacNamespace::synthetic_params params;
+    uint64_t frames = 300;
+    double fps = 30;
+    bool raw = false;
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--raw")
+            raw = true;
+        else if ((arg == "--frames") && has_value)
+            frames = std::stoull(argv[++i]);
+        else if ((arg == "--size") && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &params.width, &params.height) != 2) {
+                std::cout << "Ошибка: размер кадра задаётся как WxH" << std::endl;
+                return 1;
+            }
+        } else if ((arg == "--noise") && has_value)
+            params.noise = std::stod(argv[++i]);
+        else if ((arg == "--shadows") && has_value)
+            params.shadows = std::stoul(argv[++i]);
+        else if ((arg == "--clutter") && has_value)
+            params.clutter = std::stoul(argv[++i]);
+        else if ((arg == "--seed") && has_value)
+            params.seed = std::stoull(argv[++i]);
+        else if ((arg == "--fps") && has_value)
+            fps = std::stod(argv[++i]);
+        else
+            positional.push_back(arg);
+    }
+    if (positional.size() == 1) {
+        out_path = positional[0];
+    } else if (positional.size() == 2) {
+        config_path = positional[0];
+        out_path = positional[1];
+    } else {
+        std::cout << "Использование: lane_synth [файл конфигурации] <выход> [--frames N] [--size WxH] "
+                     "[--noise S] [--shadows N] [--clutter N] [--seed N] [--fps F] [--raw]" << std::endl;
+        return 1;
+    }
+    if ((params.width < 64) || (params.height < 64) || (params.width > 7680) || (params.height > 4320)) {
+        std::cout << "Ошибка: недопустимый размер кадра " << params.width << "x" << params.height << std::endl;
+        return 1;
+    }
+
+    RansacNamespace::settings init;
+    if (!init.load(config_path))
+        return 1;
+
+    RansacNamespace::synthetic_road road(init, params);
+    cv::Size size(params.width, params.height);
+
+    cv::VideoWriter video;
+    std::ofstream raw_out;
+    if (raw) {
+        raw_out.open(out_path, std::ios::binary);
+    } else {
+        video.open(out_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size);
+    }
+    if (raw ? !raw_out.is_open() : !video.isOpened()) {
+        std::cout << "Ошибка: не удалось открыть " << out_path << " для записи" << std::endl;
+        return 1;
+    }
+
+    std::ofstream truth_out(out_path + ".truth.csv");
+    if (!truth_out.is_open()) {
+        std::cout << "Ошибка: не удалось открыть " << out_path << ".truth.csv для записи" << std::endl;
+        return 1;
+    }
+    truth_out << "frame,lane,solid,a,b,c\n" << std::setprecision(10);
+
+    cv::Mat img;
+    RansacNamespace::lane_polys truth{};
+    std::vector<bool> solid;
+    for (uint64_t frame = 0; frame < frames; frame++) {
+        road.render(frame, img, truth, solid);
+        if (raw)
+            raw_out.write(reinterpret_cast<const char*>(img.data), static_cast<std::streamsize>(img.total() * img.elemSize()));
+        else
+            video.write(img);
+        for (size_t k = 0; k < truth.size(); k++) {
+            truth_out << frame << ',' << k << ',' << (solid[k] ? 1 : 0) << ','
+                      << truth[k].a << ',' << truth[k].b << ',' << truth[k].c << '\n';
+        }
+    }
+
+    // Конфигурация для обработки сгенерированного видео.
+    RansacNamespace::settings synth = init;
+    synth.video_name = out_path;
+    synth.parametersBird = road.bird_parameters();
+    if (!synth.save(out_path + ".yaml"))
+        return 1;
+
+    std::cout << "Записано кадров: " << frames << " (" << params.width << "x" << params.height << ") в " << out_path << std::endl;
+    return 0;
+}
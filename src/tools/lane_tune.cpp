@@ -0,0 +1,35 @@
+#include "../../include/Ransac.h"
+
+/**
+ * Интерактивная настройка bird и HSV параметров.
+ * Загружает конфигурацию, открывает видео один раз, по очереди показывает окна настройки
+ * и записывает результат обратно в файл конфигурации.
+ *
+ * Использование: lane_tune [файл конфигурации] [видео]
+ */
+int main(int argc, char** argv) {
+    std::string config_path = argc > 1 ? argv[1] : "../data/config.yaml";
+
+    RansacNamespace::settings init;
+    if (!init.load(config_path))
+        return 1;
+    if (argc > 2)
+        init.video_name = argv[2];
+
+    cv::VideoCapture vid(init.video_name);
+    if (!vid.isOpened()) {
+        std::cout << "Ошибка: не удалось открыть видео " << init.video_name << std::endl;
+        return 1;
+    }
+
+    RansacNamespace::Bird_view bird_img;
+    bird_img.get_parameters(vid, init.parametersBird);
+
+    vid.set(cv::CAP_PROP_POS_FRAMES, 0);
+    RansacNamespace::hsv::get_parameters(vid, init.parametersHSV);
+
+    if (!init.validate() || !init.save(config_path))
+        return 1;
+    std::cout << "Параметры сохранены в " << config_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "../../include/Ransac.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * Опрос сервера метрик по петлевому интерфейсу (как Prometheus).
+ *
+ * Использование:
+ *   metrics_scrape <порт>                      - вывести метрики работающего RANSAC2 (metrics_port в конфигурации)
+ *   metrics_scrape --check <конфигурация> [N]   - проверка: N синтетических кадров (по умолчанию 100) обрабатываются
+ *                                                в отдельном потоке, сервер метрик открывается на свободном порту,
+ *                                                метрики опрашиваются в цикле во время обработки и после неё
+ *
+ * В режиме --check код возврата 1, если опрос не удался, нет обязательной метрики, lane_frames_total
+ * уменьшилось между опросами, обработка остановилась из-за клиента без запроса
+ * или итоговое lane_frames_total не совпадает с количеством обработанных кадров.
+ */
+
+/// Значение метрики без меток (первая строка "name value"), -1 - метрики нет или значение не число.
+static double metric_value(const std::string& body, const std::string& name) {
+    size_t pos = 0;
+    while ((pos = body.find(name + " ", pos)) != std::string::npos) {
+        if ((pos == 0) || (body[pos - 1] == '\n')) {
+            std::string value = body.substr(pos + name.size() + 1, body.find('\n', pos) - pos - name.size() - 1);
+            try {
+                return std::stod(value);
+            } catch (const std::exception&) {
+                std::cout << "Ошибка: значение метрики " << name << " не число: \"" << value << "\"" << std::endl;
+                return -1;
+            }
+        }
+        pos += name.size();
+    }
+    return -1;
+}
+
+/// Соединение с сервером метрик без запроса (зависший клиент), -1 - не удалось подключиться.
+static int idle_client(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((fd >= 0) && (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * Проверка под нагрузкой: кадры обрабатываются в отдельном потоке, а этот поток опрашивает сервер,
+ * пока обработка идёт. lane_frames_total в каждом ответе не меньше предыдущего; пока клиент держит
+ * соединение без запроса, обработка продолжается; после обработки значение равно количеству кадров.
+ */
+static int check(const std::string& config_path, uint64_t frames) {
+    RansacNamespace::settings init;
+    if (!init.load(config_path))
+        return 1;
+
+    RansacNamespace::LaneDetector detector(init);
+    RansacNamespace::lane_metrics metrics(detector);
+    RansacNamespace::metrics_server server(metrics, 0);
+    if (!server.is_open())
+        return 1;
+
+    std::atomic<uint64_t> processed{0};
+    std::atomic<bool> done{false};
+    bool detect_ok = true;
+    std::thread detection([&]() {
+        RansacNamespace::synthetic_source source(init, RansacNamespace::synthetic_params{}, frames,
+                                                 RansacNamespace::frame_format::bgr, 2);
+        RansacNamespace::LaneDetector::Result result;
+        RansacNamespace::external_frame input;
+        cv::Mat frame;
+        while (source.next(input)) {
+            if (!RansacNamespace::wrap_frame(input, frame)) {
+                RansacNamespace::release_frame(input);
+                detect_ok = false;
+                break;
+            }
+            detector.process(frame, result);
+            metrics.record(result);
+            frame.release();
+            RansacNamespace::release_frame(input);
+            processed.fetch_add(1, std::memory_order_release);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    bool ok = true;
+    std::string body;
+    double last = 0;
+    size_t scrapes = 0;
+    bool idle_checked = false;
+    while (ok && !done.load(std::memory_order_acquire)) {
+        if (!RansacNamespace::scrape_metrics(server.port(), body)) {
+            ok = false;
+            break;
+        }
+        scrapes++;
+        double value = metric_value(body, "lane_frames_total");
+        if (value < 0) {
+            std::cout << "Ошибка: нет метрики lane_frames_total во время обработки" << std::endl;
+            ok = false;
+        } else if (value < last) {
+            std::cout << "Ошибка: lane_frames_total уменьшилось во время обработки: " << last << " -> " << value << std::endl;
+            ok = false;
+        }
+        last = value;
+
+        // Клиент подключился и ничего не отправляет: сервер ждёт его, но кадры обрабатываются дальше.
+        if (!idle_checked) {
+            idle_checked = true;
+            int idle = idle_client(server.port());
+            if (idle < 0) {
+                std::cout << "Ошибка: нет соединения с сервером метрик" << std::endl;
+                ok = false;
+                break;
+            }
+            uint64_t before = processed.load(std::memory_order_acquire);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while ((processed.load(std::memory_order_acquire) == before) && !done.load(std::memory_order_acquire) &&
+                   (std::chrono::steady_clock::now() < deadline))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if ((processed.load(std::memory_order_acquire) == before) && !done.load(std::memory_order_acquire)) {
+                std::cout << "Ошибка: обработка кадров остановилась, пока клиент держит соединение без запроса" << std::endl;
+                ok = false;
+            }
+            close(idle);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    detection.join();
+    if (!ok || !detect_ok || !RansacNamespace::scrape_metrics(server.port(), body))
+        return 1;
+
+    const char *required[] = {"lane_frames_total", "lane_fps", "lane_frames_with_lines_total", "lane_stripes_total",
+                              "lane_empty_stripes_total", "lane_points_per_frame_count", "lane_reused_frames_total",
+                              "lane_telemetry_dropped_total", "lane_tracked_lines", "lane_quality_level"};
+    for (const char *name : required) {
+        if (metric_value(body, name) < 0) {
+            std::cout << "Ошибка: нет метрики " << name << std::endl;
+            ok = false;
+        }
+    }
+    if (body.find("lane_stage_latency_seconds{stage=") == std::string::npos) {
+        std::cout << "Ошибка: нет задержек этапов lane_stage_latency_seconds" << std::endl;
+        ok = false;
+    }
+    uint64_t total = processed.load(std::memory_order_acquire);
+    double reported = metric_value(body, "lane_frames_total");
+    if (std::abs(reported - static_cast<double>(total)) > 1e-9) {
+        std::cout << "Ошибка: lane_frames_total " << reported << ", обработано " << total << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "OK" : "Ошибка") << ": порт " << server.port() << ", запросов " << server.requests()
+              << ", из них во время обработки " << scrapes << ", кадров " << total << std::endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    std::string first = argc > 1 ? argv[1] : "";
+    if ((first == "--check") && (argc > 2))
+        return check(argv[2], argc > 3 ? std::stoull(argv[3]) : 100);
+    if (first.empty() || (first[0] == '-')) {
+        std::cout << "Использование: metrics_scrape <порт> | metrics_scrape --check <конфигурация> [кадров]" << std::endl;
+        return 1;
+    }
+
+    std::string body;
+    if (!RansacNamespace::scrape_metrics(static_cast<uint16_t>(std::stoul(first)), body))
+        return 1;
+    std::cout << body;
+    return 0;
+}
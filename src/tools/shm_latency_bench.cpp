@@ -0,0 +1,111 @@
+#include "../../include/lane_shm.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Замер задержки публикатор -> подписчик через сегмент разделяемой памяти.
+ * Подписчик запускается отдельным процессом (fork), сеть не используется.
+ *
+ * Использование: shm_latency_bench [кадров] [частота, Гц] [слотов]
+ */
+
+using namespace RansacNamespace;
+
+static void print_percentiles(std::vector<int64_t>& latency, uint64_t missed) {
+    if (latency.empty()) {
+        std::cout << "Подписчик не получил ни одного кадра" << std::endl;
+        return;
+    }
+    std::sort(latency.begin(), latency.end());
+    auto p = [&latency](double q) {
+        size_t i = static_cast<size_t>(q * static_cast<double>(latency.size() - 1));
+        return static_cast<double>(latency[i]) / 1000.0;
+    };
+    std::cout << "Получено кадров: " << latency.size() << ", пропущено: " << missed << "\n";
+    std::cout << "Задержка, мкс: p50 " << p(0.50) << "  p90 " << p(0.90) << "  p99 " << p(0.99)
+              << "  p99.9 " << p(0.999) << "  max " << p(1.0) << std::endl;
+}
+
+/// Подписчик: опрашивает write_seq и читает каждый новый кадр.
+static int run_subscriber(const std::string& name, uint64_t frames) {
+    lane_shm_reader reader;
+    if (!reader.open(name)) {
+        std::cout << "Ошибка: подписчик не подключился к " << name << std::endl;
+        return 1;
+    }
+    std::vector<int64_t> latency;
+    latency.reserve(frames);
+    uint64_t missed = 0;
+    uint64_t expected = 1;
+    lane_shm_frame frame{};
+
+    while (expected <= frames) {
+        uint64_t last = reader.last_sequence();
+        if (last < expected) {
+            std::this_thread::yield();
+            continue;
+        }
+        int res = reader.read(last, frame);
+        if (res != 1)
+            continue;
+        latency.push_back(lane_shm_now_ns() - frame.publish_ns);
+        missed += last - expected;
+        expected = last + 1;
+    }
+    print_percentiles(latency, missed);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    double rate = argc > 2 ? std::strtod(argv[2], nullptr) : 1000.0;
+    uint32_t capacity = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 64;
+    if (frames == 0)
+        frames = 1;
+
+    std::string name = "/lane_bench_" + std::to_string(getpid());
+    lane_shm_publisher publisher;
+    if (!publisher.open(name, capacity))
+        return 1;
+
+    pid_t child = fork();
+    if (child < 0) {
+        std::cout << "Ошибка: fork" << std::endl;
+        return 1;
+    }
+    if (child == 0)
+        _exit(run_subscriber(name, frames));
+
+    // Даём подписчику подключиться.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int64_t period_ns = rate > 0 ? static_cast<int64_t>(1e9 / rate) : 0;
+    int64_t next = lane_shm_now_ns();
+    lane_shm_frame frame{};
+    frame.stripes = 4;
+    for (uint64_t i = 0; i < frames; i++) {
+        // Ожидание следующего кадра: сон на большую часть периода, затем уступка процессора.
+        int64_t wait = next - lane_shm_now_ns();
+        if (wait > 100000)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait - 50000));
+        while (lane_shm_now_ns() < next)
+            std::this_thread::yield();
+        next += period_ns;
+        frame.frame = i;
+        frame.capture_ns = lane_shm_now_ns();
+        publisher.publish(frame);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    publisher.close();
+    std::cout << "Кадров опубликовано: " << frames << ", частота " << rate << " Гц, слотов " << capacity << std::endl;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,179 @@
+#include "../include/Ransac.h"
+
+#include <mutex>
+
+namespace RansacNamespace {
+
+    namespace {
+
+        struct trace_event {
+            const char* name;
+            uint64_t frame;
+            int64_t ts_ns;
+            char phase; // 'B' - начало, 'E' - конец
+        };
+
+        /// Буфер событий одного потока. Блокировка захватывается только владельцем и при выгрузке.
+        struct trace_buffer {
+            std::mutex lock;
+            std::vector<trace_event> events;
+            size_t next = 0;
+            size_t count = 0;
+            uint32_t tid = 0;
+            std::string name;
+        };
+
+        std::mutex registry_lock;
+        std::vector<std::shared_ptr<trace_buffer>> buffers;
+        size_t buffer_capacity = 0;
+        int64_t origin_ns = 0;
+
+        thread_local std::shared_ptr<trace_buffer> local_buffer;
+        thread_local uint64_t local_frame = 0;
+
+        int64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /// Буфер текущего потока (создаётся и регистрируется при первом обращении).
+        trace_buffer& this_thread_buffer() {
+            if (!local_buffer) {
+                auto buffer = std::make_shared<trace_buffer>();
+                std::lock_guard<std::mutex> guard(registry_lock);
+                buffer->tid = static_cast<uint32_t>(buffers.size() + 1);
+                buffer->events.resize(buffer_capacity);
+                buffers.push_back(buffer);
+                local_buffer = buffer;
+            }
+            return *local_buffer;
+        }
+
+        void append(const char* name, char phase) {
+            int64_t ts = now_ns();
+            trace_buffer &buffer = this_thread_buffer();
+            std::lock_guard<std::mutex> guard(buffer.lock);
+            if (buffer.events.empty())
+                return;
+            buffer.events[buffer.next] = {name, local_frame, ts, phase};
+            buffer.next = (buffer.next + 1) % buffer.events.size();
+            buffer.count = std::min(buffer.count + 1, buffer.events.size());
+        }
+
+        /// Экранирование строки для JSON.
+        std::string json_escape(const std::string& s) {
+            std::string out;
+            for (char c : s) {
+                if ((c == '"') || (c == '\\'))
+                    out += '\\';
+                if (static_cast<unsigned char>(c) >= 0x20)
+                    out += c;
+            }
+            return out;
+        }
+    }
+
+    std::atomic<bool> trace::active{false};
+
+/**
+ * Включает запись событий. Буферы уже зарегистрированных потоков очищаются.
+ *
+ * @param events_per_thread - количество событий в кольцевом буфере каждого потока.
+ */
+    void trace::enable(size_t events_per_thread) {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        buffer_capacity = events_per_thread;
+        origin_ns = now_ns();
+        for (auto &buffer : buffers) {
+            std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+            buffer->events.assign(buffer_capacity, trace_event{});
+            buffer->next = 0;
+            buffer->count = 0;
+        }
+        active.store(true, std::memory_order_release);
+    }
+
+    void trace::disable() {
+        active.store(false, std::memory_order_release);
+    }
+
+    void trace::begin(const char* name) {
+        append(name, 'B');
+    }
+
+    void trace::end(const char* name) {
+        append(name, 'E');
+    }
+
+    void trace::set_frame(uint64_t frame) {
+        local_frame = frame;
+    }
+
+    void trace::set_thread_name(const std::string& name) {
+        trace_buffer &buffer = this_thread_buffer();
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.name = name;
+    }
+
+/**
+ * Записывает события всех потоков в формате Chrome trace JSON.
+ * Время - микросекунды от вызова enable(). События конца без начала
+ * (начало вытеснено из буфера) пропускаются.
+ *
+ * @param path - путь к файлу.
+ * @return false, если файл не удалось открыть.
+ */
+    bool trace::dump(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            std::cout << "Ошибка: не удалось открыть " << path << " для записи трассировки" << std::endl;
+            return false;
+        }
+
+        std::vector<std::shared_ptr<trace_buffer>> snapshot;
+        int64_t origin;
+        {
+            std::lock_guard<std::mutex> guard(registry_lock);
+            snapshot = buffers;
+            origin = origin_ns;
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << std::fixed << std::setprecision(3);
+        bool first = true;
+        for (auto &buffer : snapshot) {
+            std::vector<trace_event> events;
+            std::string name;
+            uint32_t tid;
+            {
+                std::lock_guard<std::mutex> guard(buffer->lock);
+                size_t size = buffer->events.size();
+                for (size_t i = 0; i < buffer->count; i++)
+                    events.push_back(buffer->events[(buffer->next + size - buffer->count + i) % size]);
+                name = buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name;
+                tid = buffer->tid;
+            }
+
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"" << json_escape(name) << "\"}}";
+            first = false;
+
+            size_t depth = 0;
+            for (auto &e : events) {
+                if (e.phase == 'E') {
+                    if (depth == 0)
+                        continue;
+                    depth--;
+                } else {
+                    depth++;
+                }
+                out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << static_cast<double>(e.ts_ns - origin) / 1e3
+                    << ",\"args\":{\"frame\":" << e.frame << "}}";
+            }
+        }
+        out << "\n]}\n";
+        return out.good();
+    }
+
+}
@@ -0,0 +1,168 @@
+#include "../include/Ransac.h"
+
+
+
+namespace RansacNamespace {
+
+
+/**
+ * Интерактивная настройка параметров перспективной трансформации.
+ * Открывается окно с ползунками, настройка завершается клавишей 'e'.
+ *
+ * @param vid - открытый видеопоток (используется тот же, что и для детекции).
+ * @param parameters - параметры bird преобразования (подробнее в return_bird_matrix()), изменяются на месте.
+ */
+    void Bird_view::get_parameters(cv::VideoCapture& vid, std::vector<int>& parameters) {
+        parameters.resize(10, 0);
+
+        cv::namedWindow("result");
+        cv::namedWindow("start video");
+        cv::namedWindow("settings");
+
+        cv::Mat img;
+        vid.read(img);
+        int height = img.rows;
+        int width = img.cols;
+
+        // Создаем ползунки для настройки параметров.
+        cv::createTrackbar("1 point h", "settings", &parameters[1], height, nullptr);
+        cv::createTrackbar("1 point w", "settings", &parameters[0], width, nullptr);
+        cv::createTrackbar("2 point h", "settings", &parameters[3], height, nullptr);
+        cv::createTrackbar("2 point w", "settings", &parameters[2], width, nullptr);
+        cv::createTrackbar("3 point h", "settings", &parameters[5], height, nullptr);
+        cv::createTrackbar("3 point w", "settings", &parameters[4], width, nullptr);
+        cv::createTrackbar("4 point h", "settings", &parameters[7], height, nullptr);
+        cv::createTrackbar("4 point w", "settings", &parameters[6], width, nullptr);
+        cv::createTrackbar("image h", "settings", &parameters[8], height, nullptr);
+        cv::createTrackbar("image w", "settings", &parameters[9], width, nullptr);
+
+        while (cv::waitKey(1) != 'e') {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (!vid.read(img) || img.empty()) {
+                // Видео закончилось - начинаем сначала.
+                vid.set(cv::CAP_PROP_POS_FRAMES, 0);
+                continue;
+            }
+            cv::waitKey(0);
+            int p1h = cv::getTrackbarPos("1 point h", "settings");
+            int p1w = cv::getTrackbarPos("1 point w", "settings");
+            int p2h = cv::getTrackbarPos("2 point h", "settings");
+            int p2w = cv::getTrackbarPos("2 point w", "settings");
+            int p3h = cv::getTrackbarPos("3 point h", "settings");
+            int p3w = cv::getTrackbarPos("3 point w", "settings");
+            int p4h = cv::getTrackbarPos("4 point h", "settings");
+            int p4w = cv::getTrackbarPos("4 point w", "settings");
+            int h = cv::getTrackbarPos("image h", "settings");
+            int w = cv::getTrackbarPos("image w", "settings");
+
+            // Обновляем параметры.
+            parameters[0] = p1w;
+            parameters[1] = p1h;
+            parameters[2] = p2w;
+            parameters[3] = p2h;
+            parameters[4] = p3w;
+            parameters[5] = p3h;
+            parameters[6] = p4w;
+            parameters[7] = p4h;
+            parameters[8] = h;
+            parameters[9] = w;
+
+            if ((h <= 0) || (w <= 0))
+                continue;
+
+            std::vector<cv::Mat> matrix = return_bird_matrix(parameters);
+            cv::Mat bird_image;
+            warpImage(img, img, matrix, parameters, bird_image, 'n');
+            cv::imshow("result", bird_image);
+
+            // Рисуем точки на изображении и выводим параметры.
+            cv::circle(img, cv::Point(p1w, p1h), 3, cv::Scalar(0, 0, 255), -1);
+            cv::circle(img, cv::Point(p2w, p2h), 3, cv::Scalar(0, 0, 255), -1);
+            cv::circle(img, cv::Point(p3w, p3h), 3, cv::Scalar(0, 0, 255), -1);
+            cv::circle(img, cv::Point(p4w, p4h), 3, cv::Scalar(0, 0, 255), -1);
+
+            cv::putText(img, "P 1 : (" + std::to_string(p1w) + ", " + std::to_string(p1h) + ")",
+                        cv::Point(p1w + 10, p1h - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 2);
+            cv::putText(img, "P 2 : (" + std::to_string(p2w) + ", " + std::to_string(p2h) + ")",
+                        cv::Point(p2w + 10, p2h - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 2);
+            cv::putText(img, "P 3 : (" + std::to_string(p3w) + ", " + std::to_string(p3h) + ")",
+                        cv::Point(p3w + 10, p3h - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 2);
+            cv::putText(img, "P 4 : (" + std::to_string(p4w) + ", " + std::to_string(p4h) + ")",
+                        cv::Point(p4w + 10, p4h - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 2);
+
+            cv::imshow("start video", img);
+        }
+
+        cv::destroyAllWindows();
+
+        // Вывод параметров.
+        std::cout << "\nПараметры обзора сверху: \n";
+        std::cout << "\nP 1 : x " << parameters[0] << " y " << parameters[1] << "\n";
+        std::cout << "P 2 : x " << parameters[2] << " y " << parameters[3] << "\n";
+        std::cout << "P 3 : x " << parameters[4] << " y " << parameters[5] << "\n";
+        std::cout << "P 4 : x " << parameters[6] << " y " << parameters[7] << "\n\n";
+    }
+
+
+
+/**
+ * Интерактивная настройка параметров HSV-фильтрации.
+ * Значения изменяются ползунками на окне настроек, настройка завершается клавишей 'w'.
+ *
+ * @param vid - открытый видеопоток.
+ * @param parameters - вектор параметров цветового фильтра [h1, s1, v1, h2, s2, v2], изменяется на месте.
+ */
+    void hsv::get_parameters(cv::VideoCapture& vid, std::vector<int>& parameters) {
+        parameters.resize(6, 255);
+        std::string names[6] = {"h1", "s1", "v1", "h2", "s2", "v2"};
+        cv::Scalar h_max, h_min;
+
+        cv::namedWindow("result");
+        cv::namedWindow("settings");
+
+        // Создание ползунков для настройки параметров.
+        for (size_t i = 0; i < 6; i++) {
+            cv::createTrackbar(names[i], "settings", &parameters[i], 255, nullptr);
+        }
+
+        while (cv::waitKey(1) != 'w') {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            cv::Mat img;
+            if (!vid.read(img) || img.empty()) {
+                // Видео закончилось - начинаем сначала.
+                vid.set(cv::CAP_PROP_POS_FRAMES, 0);
+                continue;
+            }
+            cv::Mat hsv;
+            cv::cvtColor(img, hsv, cv::COLOR_BGR2HLS);
+            cv::waitKey(0);
+            // Получение текущих значений параметров HSV.
+            for (size_t i = 0; i < 6; i++)
+                parameters[i] = cv::getTrackbarPos(names[i], "settings");
+
+            h_min = cv::Scalar(parameters[0], parameters[1], parameters[2]);
+            h_max = cv::Scalar(parameters[3], parameters[4], parameters[5]);
+
+            cv::Mat img_hsv;
+            cv::imshow("r", img);
+            cv::inRange(hsv, h_min, h_max, img_hsv);
+            cv::imshow("result", img_hsv);
+        }
+
+        cv::destroyAllWindows();
+
+        // Вывод на экран текущих значений параметров HSV.
+        std::cout << "\nВаши параметры HSV: \n\n";
+        std::cout << "Минимальные: ";
+        std::cout << " h: " << parameters[0];
+        std::cout << " s: " << parameters[1];
+        std::cout << " v: " << parameters[2];
+        std::cout << "\nМаксимальные: ";
+        std::cout << " h: " << parameters[3];
+        std::cout << " s: " << parameters[4];
+        std::cout << " v: " << parameters[5];
+        std::cout << "\n\n";
+    }
+
+
+}